@@ -0,0 +1,474 @@
+#ifndef _ALLOCATOR_H_
+#define _ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace zrdw {
+
+	/*
+	allocators for zrdw::vector, all share the std-like surface vector needs:
+	value_type, allocate(n), deallocate(p, n), a converting ctor from allocator<U>, and == / !=
+	*/
+
+	//alignment an allocator guarantees, Alloc::alignment if it declares one, else alignof(value_type)
+	template <typename A, typename = void>
+	struct alloc_alignment { static constexpr size_t value = alignof(typename A::value_type); };
+	template <typename A>
+	struct alloc_alignment<A, decltype((void)A::alignment)> { static constexpr size_t value = A::alignment; };
+
+	/*
+	whether an allocator can resize a buffer keeping its bytes (reallocate(p, old_n, new_n)),
+	vector then grows trivially copyable elems in place instead of copying them to a second buffer.
+	such an allocator also tells, by copies(old_n, new_n), whether that resize copies the bytes rather than remapping them
+	*/
+	template <typename A, typename = void>
+	struct alloc_remaps : public std::false_type {
+		static typename A::value_type* reallocate(A&, typename A::value_type* p, size_t, size_t) { return p; } // never called
+		static bool copies(const A&, size_t, size_t) { return false; }
+	};
+	template <typename A>
+	struct alloc_remaps<A, decltype((void)&A::reallocate)> : public std::true_type {
+		static typename A::value_type* reallocate(A& a, typename A::value_type* p, size_t old_n, size_t new_n) {
+			return a.reallocate(p, old_n, new_n);
+		}
+		static bool copies(const A& a, size_t old_n, size_t new_n) {
+			return a.copies(old_n, new_n);
+		}
+	};
+
+	//default allocator, straight to the global heap
+	template <typename T>
+	struct heap_allocator {
+		using value_type = T;
+
+		heap_allocator(void) {}
+		template <typename U>
+		heap_allocator(const heap_allocator<U>&) {}
+
+		T* allocate(size_t n) {
+			return (T*) ::operator new(n*sizeof(T));
+		}
+
+		void deallocate(T* p, size_t) {
+			::operator delete(p);
+		}
+
+		template <typename U>
+		bool operator==(const heap_allocator<U>&) const { return true; }
+		template <typename U>
+		bool operator!=(const heap_allocator<U>&) const { return false; }
+	};
+
+
+	/*
+	over-aligned heap allocator through aligned new, Align is typically 32 (AVX) or 64 (cache line / AVX-512).
+	a vector using it keeps front on an Align boundary whenever it reallocates, see vector::is_aligned()
+	*/
+	template <typename T, size_t Align = 64>
+	struct aligned_allocator {
+		static_assert((Align & (Align - 1)) == 0 && Align >= alignof(T), "Align must be a power of two no less than alignof(T)");
+		using value_type = T;
+		static constexpr size_t alignment = Align;
+
+		aligned_allocator(void) {}
+		template <typename U>
+		aligned_allocator(const aligned_allocator<U, Align>&) {}
+
+		T* allocate(size_t n) {
+			return (T*) ::operator new(n*sizeof(T), std::align_val_t(Align));
+		}
+
+		void deallocate(T* p, size_t) {
+			::operator delete(p, std::align_val_t(Align));
+		}
+
+		template <typename U>
+		bool operator==(const aligned_allocator<U, Align>&) const { return true; }
+		template <typename U>
+		bool operator!=(const aligned_allocator<U, Align>&) const { return false; }
+	};
+
+
+	/*
+	inline_allocator keeps a buffer of N elems inside the allocator object itself, so a vector using it
+	stays off the heap until it outgrows N. the inline buffer is handed out to one allocation at a time,
+	every other request goes to the heap. copies start with a fresh, unused buffer
+	*/
+	template <typename T, size_t N>
+	struct inline_allocator {
+		using value_type = T;
+		alignas(T) unsigned char buf[N*sizeof(T)];
+		bool used;
+
+		inline_allocator(void) : used(false) {}
+		inline_allocator(const inline_allocator&) : used(false) {}
+		inline_allocator& operator=(const inline_allocator&) { return *this; } // the buffer stays with its owner
+
+		T* allocate(size_t n) {
+			if (!used && n <= N) {
+				used = true;
+				return (T*)buf;
+			}
+			return (T*) ::operator new(n*sizeof(T));
+		}
+
+		void deallocate(T* p, size_t) {
+			if (p == (T*)buf) used = false;
+			else ::operator delete(p);
+		}
+
+		bool operator==(const inline_allocator&) const { return false; }
+		bool operator!=(const inline_allocator&) const { return true; }
+	};
+
+	//tells vector whether a buffer lives inside the allocator object, and how large that inline buffer is
+	template <typename A>
+	struct inline_storage {
+		static constexpr size_t capacity = 0;
+		static bool holds(const A&, const void*) { return false; }
+	};
+	template <typename T, size_t N>
+	struct inline_storage<inline_allocator<T, N>> {
+		static constexpr size_t capacity = N;
+		static bool holds(const inline_allocator<T, N>& a, const void* p) { return p == (const void*)a.buf; }
+	};
+
+
+#if defined(__linux__)
+	/*
+	large-allocation backend: buffers of at least Threshold bytes are anonymous mmaps, started on a 2 MB boundary
+	and advised for transparent huge pages, that grow with mremap so the kernel moves page tables instead of bytes.
+	smaller buffers stay on the heap; crossing Threshold either way copies the bytes once
+	*/
+	template <typename T, size_t Threshold = (size_t)1 << 25>
+	struct mmap_allocator {
+		using value_type = T;
+
+		mmap_allocator(void) {}
+		template <typename U>
+		mmap_allocator(const mmap_allocator<U, Threshold>&) {}
+
+		static bool mapped(size_t n) {
+			return n*sizeof(T) >= Threshold;
+		}
+
+		static size_t mapped_bytes(size_t n) { // whole pages
+			return (n*sizeof(T) + 4095) & ~(size_t)4095;
+		}
+
+		static constexpr size_t huge_page = (size_t)1 << 21;
+
+		// bytes of fresh map from a huge page boundary, which a plain mmap does not give: mapped one huge page over, the ends unmapped
+		static void* map_aligned(size_t bytes) {
+			size_t over = bytes + huge_page;
+			char* p = (char*)mmap(nullptr, over, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == (char*)MAP_FAILED) throw std::bad_alloc();
+			char* q = (char*)(((uintptr_t)p + huge_page - 1) & ~(uintptr_t)(huge_page - 1));
+			if (q > p) munmap(p, q - p);
+			if (q + bytes < p + over) munmap(q + bytes, (p + over) - (q + bytes));
+			return q;
+		}
+
+		static void advise(void* p, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+			madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+		}
+
+		T* allocate(size_t n) {
+			if (!mapped(n)) return (T*) ::operator new(n*sizeof(T));
+			void* p = map_aligned(mapped_bytes(n));
+			advise(p, mapped_bytes(n));
+			return (T*)p;
+		}
+
+		void deallocate(T* p, size_t n) {
+			if (p == nullptr) return;
+			if (!mapped(n)) ::operator delete(p);
+			else munmap(p, mapped_bytes(n));
+		}
+
+		/*
+		bytes [0, min(old_n, new_n)*sizeof(T)) are kept. a map grows in place when the pages after it are free,
+		else it is moved (MREMAP_FIXED) onto a fresh aligned map, which keeps it on a huge page boundary
+		*/
+		T* reallocate(T* p, size_t old_n, size_t new_n) {
+			if (p != nullptr && mapped(old_n) && mapped(new_n)) {
+				size_t old_bytes = mapped_bytes(old_n), new_bytes = mapped_bytes(new_n);
+				void* q = mremap(p, old_bytes, new_bytes, 0);
+				if (q == MAP_FAILED) {
+					void* to = map_aligned(new_bytes);
+					q = mremap(p, old_bytes, new_bytes, MREMAP_MAYMOVE | MREMAP_FIXED, to);
+					if (q == MAP_FAILED) {
+						munmap(to, new_bytes);
+						throw std::bad_alloc();
+					}
+				}
+				advise(q, new_bytes);
+				return (T*)q;
+			}
+			size_t keep = ((old_n < new_n) ? old_n : new_n)*sizeof(T);
+			T* q = allocate(new_n);
+			if (p != nullptr) std::memcpy((void*)q, (const void*)p, keep);
+			deallocate(p, old_n);
+			return q;
+		}
+
+		// whether reallocate copies the bytes: unless both sizes are mapped, or there is nothing to keep
+		static bool copies(size_t old_n, size_t new_n) {
+			return old_n > 0 && new_n > 0 && !(mapped(old_n) && mapped(new_n));
+		}
+
+		template <typename U>
+		bool operator==(const mmap_allocator<U, Threshold>&) const { return true; }
+		template <typename U>
+		bool operator!=(const mmap_allocator<U, Threshold>&) const { return false; }
+	};
+#endif
+
+
+	/*
+	monotonic arena: allocation bumps a pointer inside the current block, deallocation is a no-op,
+	everything is given back at once by release() or the dtor.
+	meant for request-scoped computations whose valarray temporaries all die together
+	*/
+	class arena {
+		struct block {
+			block* next;
+			size_t size; // usable bytes following the header
+		};
+
+		block* blocks;
+		char* cursor;
+		char* limit;
+		size_t block_size;
+
+		static arena*& current_ref(void) {
+			static thread_local arena* cur = nullptr;
+			return cur;
+		}
+
+		void new_block(size_t min_bytes) {
+			size_t size = (min_bytes > block_size) ? min_bytes : block_size;
+			block* b = (block*) ::operator new(sizeof(block) + size);
+			b->next = blocks;
+			b->size = size;
+			blocks = b;
+			cursor = (char*)(b + 1);
+			limit = cursor + size;
+		}
+
+	public:
+		explicit arena(size_t block_size = 1 << 20) : blocks(nullptr), cursor(nullptr), limit(nullptr), block_size(block_size) {}
+		arena(const arena&) = delete;
+		arena& operator=(const arena&) = delete;
+
+		~arena(void) {
+			release();
+		}
+
+		void* allocate(size_t bytes, size_t align) {
+			uintptr_t p = ((uintptr_t)cursor + align - 1) & ~(uintptr_t)(align - 1);
+			if (cursor == nullptr || p + bytes > (uintptr_t)limit) {
+				new_block(bytes + align);
+				p = ((uintptr_t)cursor + align - 1) & ~(uintptr_t)(align - 1);
+			}
+			cursor = (char*)(p + bytes);
+			return (void*)p;
+		}
+
+		// give every block back, O(number of blocks) regardless of how many allocations were made
+		void release(void) {
+			while (blocks != nullptr) {
+				block* next = blocks->next;
+				::operator delete(blocks);
+				blocks = next;
+			}
+			cursor = limit = nullptr;
+		}
+
+		// the arena installed by the innermost arena_scope of this thread, nullptr if none
+		static arena* current(void) {
+			return current_ref();
+		}
+
+		friend class arena_scope;
+	};
+
+	//installs an arena as the current one of this thread for the lifetime of the scope
+	class arena_scope {
+		arena* prev;
+	public:
+		explicit arena_scope(arena& a) : prev(arena::current_ref()) { arena::current_ref() = &a; }
+		arena_scope(const arena_scope&) = delete;
+		arena_scope& operator=(const arena_scope&) = delete;
+		~arena_scope(void) { arena::current_ref() = prev; }
+	};
+
+	/*
+	arena_allocator binds to the arena given, or to the current arena when default constructed,
+	so that valarray results built inside an arena_scope come from that arena.
+	with no arena at all it falls back to the global heap
+	*/
+	template <typename T>
+	struct arena_allocator {
+		using value_type = T;
+		arena* source;
+
+		arena_allocator(void) : source(arena::current()) {}
+		explicit arena_allocator(arena& a) : source(&a) {}
+		template <typename U>
+		arena_allocator(const arena_allocator<U>& a) : source(a.source) {}
+
+		T* allocate(size_t n) {
+			if (source == nullptr) return (T*) ::operator new(n*sizeof(T));
+			return (T*) source->allocate(n*sizeof(T), alignof(T));
+		}
+
+		void deallocate(T* p, size_t) {
+			if (source == nullptr) ::operator delete(p);
+			// arena memory is only given back by arena::release()
+		}
+
+		template <typename U>
+		bool operator==(const arena_allocator<U>& a) const { return source == a.source; }
+		template <typename U>
+		bool operator!=(const arena_allocator<U>& a) const { return source != a.source; }
+	};
+
+
+	/*
+	size-class pool: requests up to max_pooled bytes are rounded up to a power of two (at least 16 bytes)
+	and served from a per-class free list carved out of big chunks, larger requests go to the heap.
+	freed blocks go back to their free list, chunks are only released by the dtor
+	*/
+	class pool {
+		static constexpr size_t min_class = 16;
+		static constexpr int num_classes = 13; // 16B ... 64KB
+		static constexpr size_t max_pooled = min_class << (num_classes - 1);
+		static constexpr size_t chunk_size = 1 << 20;
+
+		struct node { node* next; };
+
+		node* free_list[num_classes];
+		node* chunks;
+
+		static pool*& current_ref(void) {
+			static thread_local pool* cur = nullptr;
+			return cur;
+		}
+
+		static int size_class(size_t bytes) {
+			int c = 0;
+			size_t size = min_class;
+			while (size < bytes) { size <<= 1; ++c; }
+			return c;
+		}
+
+		void refill(int c) {
+			size_t size = min_class << c;
+			size_t count = (chunk_size - min_class) / size;
+			if (count == 0) count = 1;
+			node* chunk = (node*) ::operator new(min_class + count*size); // first 16 bytes link the chunks
+			chunk->next = chunks;
+			chunks = chunk;
+			char* p = (char*)chunk + min_class;
+			for (size_t i = 0; i < count; ++i, p += size) {
+				node* n = (node*)p;
+				n->next = free_list[c];
+				free_list[c] = n;
+			}
+		}
+
+	public:
+		pool(void) : chunks(nullptr) {
+			for (int c = 0; c < num_classes; ++c) free_list[c] = nullptr;
+		}
+		pool(const pool&) = delete;
+		pool& operator=(const pool&) = delete;
+
+		~pool(void) {
+			while (chunks != nullptr) {
+				node* next = chunks->next;
+				::operator delete(chunks);
+				chunks = next;
+			}
+		}
+
+		void* allocate(size_t bytes) {
+			if (bytes > max_pooled) return ::operator new(bytes);
+			int c = size_class(bytes);
+			if (free_list[c] == nullptr) refill(c);
+			node* n = free_list[c];
+			free_list[c] = n->next;
+			return n;
+		}
+
+		void deallocate(void* p, size_t bytes) {
+			if (p == nullptr) return;
+			if (bytes > max_pooled) {
+				::operator delete(p);
+				return;
+			}
+			int c = size_class(bytes);
+			node* n = (node*)p;
+			n->next = free_list[c];
+			free_list[c] = n;
+		}
+
+		// the pool installed by the innermost pool_scope of this thread, nullptr if none
+		static pool* current(void) {
+			return current_ref();
+		}
+
+		friend class pool_scope;
+	};
+
+	//installs a pool as the current one of this thread for the lifetime of the scope
+	class pool_scope {
+		pool* prev;
+	public:
+		explicit pool_scope(pool& p) : prev(pool::current_ref()) { pool::current_ref() = &p; }
+		pool_scope(const pool_scope&) = delete;
+		pool_scope& operator=(const pool_scope&) = delete;
+		~pool_scope(void) { pool::current_ref() = prev; }
+	};
+
+	//pool_allocator binds like arena_allocator: to the pool given, the current pool, or the heap
+	template <typename T>
+	struct pool_allocator {
+		using value_type = T;
+		pool* source;
+
+		pool_allocator(void) : source(pool::current()) {}
+		explicit pool_allocator(pool& p) : source(&p) {}
+		template <typename U>
+		pool_allocator(const pool_allocator<U>& a) : source(a.source) {}
+
+		T* allocate(size_t n) {
+			if (source == nullptr) return (T*) ::operator new(n*sizeof(T));
+			return (T*) source->allocate(n*sizeof(T));
+		}
+
+		void deallocate(T* p, size_t n) {
+			if (source == nullptr) ::operator delete(p);
+			else source->deallocate(p, n*sizeof(T));
+		}
+
+		template <typename U>
+		bool operator==(const pool_allocator<U>& a) const { return source == a.source; }
+		template <typename U>
+		bool operator!=(const pool_allocator<U>& a) const { return source != a.source; }
+	};
+
+} //namespace zrdw
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef _BINARY_IO_H_
+#define _BINARY_IO_H_
+
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+// zrdw::vector, zrdw::valarray
+#include "Valarray.h"
+
+namespace zrdw {
+
+	/*
+	compact binary format for vector and valarray, written by save() and read back by load():
+		header   24 bytes: "ZRDW", version, endianness (1 little, 2 big), type code, scalar size,
+		         elem size (uint32), reserved (uint32), elem count (int64)
+		data     elem count * elem size bytes, as laid out in memory
+		trailer  checksum of the data bytes (uint64)
+	header and trailer fields are in the writer's byte order, given by the endianness byte.
+	arithmetic and complex elems are byte-swapped on load when the orders differ,
+	other trivially copyable elems (type code 0) load only on a machine of the same order.
+	save writes through a bounded buffer, chunk_bytes at a time, so that expressions are evaluated piecewise;
+	load reads all data with a single read into uninitialized storage
+	*/
+	namespace binary_io {
+		static constexpr char magic[4] = { 'Z', 'R', 'D', 'W' };
+		static constexpr uint8_t version = 1;
+		static constexpr int64_t chunk_bytes = 1 << 20;
+
+		enum endianness : uint8_t { little = 1, big = 2 };
+
+		inline endianness host_order(void) {
+			const uint16_t probe = 1;
+			unsigned char first;
+			std::memcpy(&first, &probe, 1);
+			return first ? little : big;
+		}
+
+		//type code and the size of the scalars to swap, registered for the types valarray allows and the fixed width integers
+		template <typename T> struct type_code { static constexpr uint8_t code = 0; static constexpr uint8_t scalar = 0; };
+		template <> struct type_code<int8_t> { static constexpr uint8_t code = 1; static constexpr uint8_t scalar = 1; };
+		template <> struct type_code<uint8_t> { static constexpr uint8_t code = 2; static constexpr uint8_t scalar = 1; };
+		template <> struct type_code<int16_t> { static constexpr uint8_t code = 3; static constexpr uint8_t scalar = 2; };
+		template <> struct type_code<uint16_t> { static constexpr uint8_t code = 4; static constexpr uint8_t scalar = 2; };
+		template <> struct type_code<int32_t> { static constexpr uint8_t code = 5; static constexpr uint8_t scalar = 4; };
+		template <> struct type_code<uint32_t> { static constexpr uint8_t code = 6; static constexpr uint8_t scalar = 4; };
+		template <> struct type_code<int64_t> { static constexpr uint8_t code = 7; static constexpr uint8_t scalar = 8; };
+		template <> struct type_code<uint64_t> { static constexpr uint8_t code = 8; static constexpr uint8_t scalar = 8; };
+		template <> struct type_code<float> { static constexpr uint8_t code = 9; static constexpr uint8_t scalar = 4; };
+		template <> struct type_code<double> { static constexpr uint8_t code = 10; static constexpr uint8_t scalar = 8; };
+		template <> struct type_code<std::complex<float>> { static constexpr uint8_t code = 11; static constexpr uint8_t scalar = 4; };
+		template <> struct type_code<std::complex<double>> { static constexpr uint8_t code = 12; static constexpr uint8_t scalar = 8; };
+
+		// reverse the bytes of each scalar-sized unit in [p, p + n)
+		inline void swap_bytes(unsigned char* p, size_t n, size_t scalar) {
+			for (size_t i = 0; i + scalar <= n; i += scalar) {
+				for (size_t lo = i, hi = i + scalar - 1; lo < hi; lo++, hi--) {
+					unsigned char c = p[lo];
+					p[lo] = p[hi];
+					p[hi] = c;
+				}
+			}
+		}
+
+		// 64-bit multiply-xor hash over little-endian 8-byte words, independent of how the data is chunked
+		class checksum {
+			uint64_t h = 0xcbf29ce484222325ULL;
+			uint64_t tail = 0;
+			int tail_len = 0;
+
+			void mix(uint64_t w) {
+				h = (h ^ w) * 0x100000001b3ULL;
+				h ^= h >> 29;
+			}
+
+			static uint64_t word(const unsigned char* p) {
+				uint64_t w;
+				std::memcpy(&w, p, 8);
+				if (host_order() == big) swap_bytes((unsigned char*)&w, 8, 8);
+				return w;
+			}
+
+		public:
+			void update(const void* data, size_t n) {
+				const unsigned char* p = (const unsigned char*)data;
+				for (; tail_len > 0 && n > 0; n--) { // finish the word left open by the previous chunk
+					tail |= uint64_t(*p++) << (8 * tail_len);
+					if (++tail_len == 8) {
+						mix(tail);
+						tail = 0;
+						tail_len = 0;
+					}
+				}
+				for (; n >= 8; p += 8, n -= 8) mix(word(p));
+				for (; n > 0; n--) tail |= uint64_t(*p++) << (8 * tail_len++);
+			}
+
+			uint64_t value(void) const {
+				checksum c = *this;
+				if (c.tail_len > 0) c.mix(c.tail ^ (uint64_t(c.tail_len) << 56));
+				return c.h;
+			}
+		};
+
+		struct header {
+			char magic[4];
+			uint8_t version, order, code, scalar;
+			uint32_t elem_size, reserved;
+			int64_t count;
+		};
+		static_assert(sizeof(header) == 24, "binary header must be packed to 24 bytes");
+
+		template <typename T>
+		void write_header(std::ostream& os, int64_t n) {
+			static_assert(std::is_trivially_copyable<T>::value, "binary save needs a trivially copyable T");
+			header h;
+			std::memcpy(h.magic, magic, 4);
+			h.version = version;
+			h.order = host_order();
+			h.code = type_code<T>::code;
+			h.scalar = type_code<T>::scalar;
+			h.elem_size = sizeof(T);
+			h.reserved = 0;
+			h.count = n;
+			os.write((const char*)&h, sizeof(h));
+		}
+
+		inline void write_trailer(std::ostream& os, const checksum& sum) {
+			uint64_t v = sum.value();
+			os.write((const char*)&v, sizeof(v));
+			if (!os) throw std::runtime_error("binary save: write failed");
+		}
+
+		// write n contiguous elems from p, chunk by chunk so that the checksum reads them while cached
+		template <typename T>
+		void write_elems(std::ostream& os, const T* p, int64_t n) {
+			write_header<T>(os, n);
+			checksum sum;
+			const int64_t chunk = (chunk_bytes / (int64_t)sizeof(T) > 0) ? chunk_bytes / (int64_t)sizeof(T) : 1;
+			for (int64_t i = 0; i < n; i += chunk) {
+				int64_t m = (n - i < chunk) ? n - i : chunk;
+				sum.update(p + i, m*sizeof(T));
+				os.write((const char*)(p + i), m*sizeof(T));
+			}
+			write_trailer(os, sum);
+		}
+
+		// bytes left in is from its read position, or -1 when it cannot seek (pipes, sockets)
+		inline int64_t remaining(std::istream& is) {
+			std::streampos at = is.tellg();
+			if (at == std::streampos(-1)) return -1;
+			if (!is.seekg(0, std::ios::end)) {
+				is.clear();
+				is.seekg(at);
+				return -1;
+			}
+			int64_t left = static_cast<int64_t>(is.tellg() - at);
+			is.seekg(at);
+			return left;
+		}
+
+		/*
+		header of a stream saved from T elems, or an exception saying why it cannot be loaded as such.
+		the count is checked before anything is allocated: against the largest byte size that fits in int64_t,
+		and, when the stream can seek, against the bytes actually left for the data and the trailer
+		*/
+		template <typename T>
+		header read_header(std::istream& is) {
+			static_assert(std::is_trivially_copyable<T>::value, "binary load needs a trivially copyable T");
+			header h;
+			if (!is.read((char*)&h, sizeof(h))) throw std::runtime_error("binary load: truncated header");
+			if (std::memcmp(h.magic, magic, 4) != 0) throw std::runtime_error("binary load: not a zrdw binary array");
+			if (h.version != version) throw std::runtime_error("binary load: unsupported version");
+			if (h.order != little && h.order != big) throw std::runtime_error("binary load: bad endianness");
+			bool swapped = h.order != host_order();
+			if (swapped) {
+				swap_bytes((unsigned char*)&h.elem_size, 4, 4);
+				swap_bytes((unsigned char*)&h.count, 8, 8);
+			}
+			if (h.code != type_code<T>::code || h.elem_size != sizeof(T)) throw std::runtime_error("binary load: elem type mismatch");
+			if (swapped && type_code<T>::code == 0) throw std::runtime_error("binary load: cannot byte-swap an untyped elem");
+			if (h.count < 0) throw std::runtime_error("binary load: negative length");
+			if (h.count > std::numeric_limits<int64_t>::max() / (int64_t)sizeof(T) - (int64_t)sizeof(uint64_t)) throw std::runtime_error("binary load: length too large");
+			int64_t left = remaining(is);
+			if (left >= 0 && left < h.count*(int64_t)sizeof(T) + (int64_t)sizeof(uint64_t)) throw std::runtime_error("binary load: truncated data");
+			return h;
+		}
+
+		// read the trailer and the data of n elems already read to p, byte-swap them if needed
+		template <typename T>
+		void finish_read(std::istream& is, const header& h, T* p, int64_t n) {
+			uint64_t stored;
+			if (!is.read((char*)&stored, sizeof(stored))) throw std::runtime_error("binary load: truncated data");
+			checksum sum;
+			sum.update(p, n*sizeof(T));
+			if (h.order != host_order()) {
+				swap_bytes((unsigned char*)&stored, 8, 8);
+				swap_bytes((unsigned char*)p, n*sizeof(T), type_code<T>::scalar);
+			}
+			if (stored != sum.value()) throw std::runtime_error("binary load: checksum mismatch");
+		}
+	}
+
+	template <typename T, typename Check, typename Alloc, typename Growth>
+	void save(std::ostream& os, const vector<T, Check, Alloc, Growth>& v) {
+		binary_io::write_elems(os, v.data(), v.size());
+	}
+
+	template <typename T, typename Check, typename Alloc, typename Growth>
+	void save(std::ostream& os, const valarray<T, vector<T, Check, Alloc, Growth>>& v) {
+		save(os, static_cast<const vector<T, Check, Alloc, Growth>&>(v));
+	}
+
+	// any other valarray, e.g. an expression: evaluated chunk by chunk into a bounded buffer
+	template <typename T, typename Expr>
+	void save(std::ostream& os, const valarray<T, Expr>& v) {
+		int64_t n = v.size();
+		binary_io::write_header<T>(os, n);
+		binary_io::checksum sum;
+		const int64_t chunk = (binary_io::chunk_bytes / (int64_t)sizeof(T) > 0) ? binary_io::chunk_bytes / (int64_t)sizeof(T) : 1;
+		vector<T> buf((n < chunk) ? n : chunk, uninitialized);
+		for (int64_t i = 0; i < n; i += chunk) {
+			int64_t m = (n - i < chunk) ? n - i : chunk;
+			T* p = buf.data();
+			evaluate(p, v, i, i + m);
+			sum.update(p, m*sizeof(T));
+			os.write((const char*)p, m*sizeof(T));
+		}
+		binary_io::write_trailer(os, sum);
+	}
+
+	// replaces v by the saved elems, v keeps its allocator; on any error v is unchanged
+	template <typename T, typename Check, typename Alloc, typename Growth>
+	void load(std::istream& is, vector<T, Check, Alloc, Growth>& v) {
+		binary_io::header h = binary_io::read_header<T>(is);
+		vector<T, Check, Alloc, Growth> temp(h.count, uninitialized, v.get_allocator());
+		if (h.count > 0 && !is.read((char*)temp.data(), h.count*sizeof(T))) throw std::runtime_error("binary load: truncated data");
+		binary_io::finish_read(is, h, temp.data(), h.count);
+		v = std::move(temp);
+	}
+
+	template <typename T, typename Check, typename Alloc, typename Growth>
+	void load(std::istream& is, valarray<T, vector<T, Check, Alloc, Growth>>& v) {
+		load(is, static_cast<vector<T, Check, Alloc, Growth>&>(v));
+	}
+
+	//file versions
+	template <typename V>
+	void save(const std::string& path, const V& v) {
+		std::ofstream os(path, std::ios::binary | std::ios::trunc);
+		if (!os) throw std::runtime_error(std::string("binary save: cannot open ") + path);
+		save(os, v);
+	}
+
+	template <typename V>
+	void load(const std::string& path, V& v) {
+		std::ifstream is(path, std::ios::binary);
+		if (!is) throw std::runtime_error(std::string("binary load: cannot open ") + path);
+		load(is, v);
+	}
+
+} //namespace zrdw
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef _CONCURRENT_VECTOR_H_
+#define _CONCURRENT_VECTOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+// zrdw::vector, zrdw::relocator, zrdw::heap_allocator
+#include "Vector.h"
+
+namespace zrdw {
+
+	/*
+	append-only vector that many threads can push_back into without a lock, for ingestion.
+	elems live in segments of doubling length (seg_init, 2*seg_init, 4*seg_init, ...) that are never moved,
+	so references stay valid until the concurrent_vector is cleared or destroyed.
+	a producer claims its index with one compare_exchange, once the segment holding it is installed by whichever
+	producer gets there first (compare_exchange, the losers free their copy).
+	nothing that can throw runs after the claim: a full vector, a failed segment allocation or a throwing
+	elem ctor leave no claimed index unconstructed. T must therefore be nothrow move constructible,
+	unless it is nothrow constructible from the arguments, in which case it is built in place
+	reading elems and freeze() require the producers to be done (joined or otherwise synchronized);
+	freeze() then copies the segments into one contiguous vector or valarray for evaluation.
+	Alloc must be usable from several threads at once, so heap_allocator/aligned_allocator but not arena/pool
+	*/
+	template <typename T, typename Alloc = heap_allocator<T>>
+	class concurrent_vector {
+		static constexpr int64_t seg_init = 64; // length of segment 0, power of two
+		static constexpr int seg_shift = 6; // log2(seg_init)
+		static constexpr int seg_max = 48; // segments needed for seg_init*(2^seg_max - 1) elems
+
+		Alloc alloc;
+		std::atomic<T*> segs[seg_max];
+		std::atomic<int64_t> len_claim; // indices handed out
+		std::atomic<int64_t> len_elem; // elems constructed
+
+		static int64_t seg_length(int k) {
+			return seg_init << k;
+		}
+
+		static int64_t seg_start(int k) {
+			return seg_init*((int64_t(1) << k) - 1);
+		}
+
+		// segment k holds indices [seg_init*(2^k - 1), seg_init*(2^(k+1) - 1))
+		static int seg_of(int64_t i) {
+			uint64_t v = (uint64_t(i) >> seg_shift) + 1;
+#if defined(__GNUC__)
+			return 63 - __builtin_clzll(v);
+#else
+			int k = 0;
+			while (v >>= 1) k++;
+			return k;
+#endif
+		}
+
+		T* segment(int k) {
+			T* s = segs[k].load(std::memory_order_acquire);
+			if (s != nullptr) return s;
+			T* fresh = alloc.allocate(seg_length(k));
+			if (segs[k].compare_exchange_strong(s, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) return fresh;
+			alloc.deallocate(fresh, seg_length(k)); // another producer installed it first, s is theirs
+			return s;
+		}
+
+		T* slot(int64_t i) const {
+			int k = seg_of(i);
+			return segs[k].load(std::memory_order_acquire) + (i - seg_start(k));
+		}
+
+		// the raw slot of the next index, claimed once its segment is in place
+		T* claim(void) {
+			int64_t i = len_claim.load(std::memory_order_relaxed);
+			for (;;) {
+				int k = seg_of(i);
+				if (k >= seg_max) throw std::length_error("concurrent_vector is full");
+				T* s = segment(k);
+				if (len_claim.compare_exchange_weak(i, i + 1, std::memory_order_relaxed)) return s + (i - seg_start(k));
+			}
+		}
+
+		template <typename... Args>
+		T* construct(std::true_type, Args&&... args) { // cannot throw, built in place
+			return new (claim()) T(std::forward<Args>(args)...);
+		}
+
+		template <typename... Args>
+		T* construct(std::false_type, Args&&... args) { // built before the claim, then moved in
+			static_assert(std::is_nothrow_move_constructible<T>::value, "concurrent_vector needs a nothrow move ctor, or nothrow construction from the arguments");
+			T temp(std::forward<Args>(args)...);
+			return new (claim()) T(std::move(temp));
+		}
+
+		template <typename... Args>
+		T& emplace(Args&&... args) {
+			T* p = construct(std::integral_constant<bool, std::is_nothrow_constructible<T, Args&&...>::value>{}, std::forward<Args>(args)...);
+			len_elem.fetch_add(1, std::memory_order_release);
+			return *p;
+		}
+
+	public:
+		using value_type = T;
+
+		explicit concurrent_vector(const Alloc& a = Alloc()) : alloc(a), len_claim(0), len_elem(0) {
+			for (int k = 0; k < seg_max; k++) segs[k].store(nullptr, std::memory_order_relaxed);
+		}
+
+		concurrent_vector(const concurrent_vector&) = delete;
+		concurrent_vector& operator=(const concurrent_vector&) = delete;
+
+		~concurrent_vector(void) {
+			clear();
+		}
+
+		// elems constructed so far, equal to the number of push_back calls once the producers are done
+		int64_t size(void) const {
+			return len_elem.load(std::memory_order_acquire);
+		}
+
+		// thread-safe, the returned reference stays valid until clear()
+		T& push_back(const T& e) {
+			return emplace(e);
+		}
+
+		T& push_back(T&& e) {
+			return emplace(std::move(e));
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args) {
+			return emplace(std::forward<Args>(args)...);
+		}
+
+		// element access, only once the producers are done
+		T& operator[](int64_t k) {
+			if (k >= size() || k<0) throw std::out_of_range("Index out of range in concurrent_vector[]");
+			return *slot(k);
+		}
+
+		const T& operator[](int64_t k) const {
+			if (k >= size() || k<0) throw std::out_of_range("Index out of range in concurrent_vector[]");
+			return *slot(k);
+		}
+
+		/*
+		copy the elems in index order into one contiguous V, e.g.
+			vector<double> v = c.freeze();
+			valarray<double> a = c.freeze<valarray<double>>();
+		reserves once and appends segment by segment, a memcpy each for trivially copyable T.
+		only once the producers are done
+		*/
+		template <typename V = vector<T>>
+		V freeze(void) const {
+			int64_t n = size();
+			if (n != len_claim.load(std::memory_order_acquire)) throw std::runtime_error("concurrent_vector: freeze while producers are running");
+			V out;
+			out.reserve(n);
+			for (int k = 0; n > 0; k++) {
+				int64_t m = (n < seg_length(k)) ? n : seg_length(k);
+				const T* s = segs[k].load(std::memory_order_acquire);
+				out.append(s, s + m);
+				n -= m;
+			}
+			return out;
+		}
+
+		// destruct all elems and free the segments, only once the producers are done
+		void clear(void) {
+			int64_t n = len_claim.load(std::memory_order_acquire);
+			for (int k = 0; k < seg_max; k++) {
+				T* s = segs[k].load(std::memory_order_acquire);
+				if (s == nullptr) continue;
+				int64_t m = n - seg_start(k);
+				if (m > seg_length(k)) m = seg_length(k);
+				if (m > 0) relocator<T>::destroy(s, m);
+				alloc.deallocate(s, seg_length(k));
+				segs[k].store(nullptr, std::memory_order_relaxed);
+			}
+			len_claim.store(0, std::memory_order_relaxed);
+			len_elem.store(0, std::memory_order_release);
+		}
+	};
+
+} //namespace zrdw
+
+#endif
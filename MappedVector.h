@@ -0,0 +1,203 @@
+#ifndef _MAPPED_VECTOR_H_
+#define _MAPPED_VECTOR_H_
+
+#if defined(__linux__)
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// zrdw::is_storage, zrdw::grow_double
+#include "Vector.h"
+
+namespace zrdw {
+
+	/*
+	vector whose elems live in a memory-mapped file, for datasets that do not fit in RAM.
+	it plugs in as the Expr of valarray, so a*b+c evaluates straight over the on-disk columns:
+		valarray<double, mapped_vector<double>> a(mapped_vector<double>("a.bin"));
+	read_only maps the file copy-on-write: elems can be written, but changes never reach the file and it cannot grow.
+	read_write maps it shared, creating the file if needed, and grows it with ftruncate + mremap;
+	the file is trimmed to size() elems when the mapped_vector is destroyed.
+	both modes advise the kernel of sequential access
+	*/
+	template <typename T, typename Growth = grow_double>
+	class mapped_vector {
+		static_assert(std::is_trivially_copyable<T>::value, "mapped_vector needs a trivially copyable T");
+	public:
+		using value_type = T;
+		enum open_mode { read_only, read_write };
+
+	private:
+		int fd;
+		bool writable;
+		T* front; // start of the mapping, elem 0 is at file offset 0
+		int64_t len_Vector; // elems mapped, the file is at least that long in read_write mode
+		int64_t len_elem;
+
+		static size_t bytes(int64_t n) {
+			return static_cast<size_t>(n)*sizeof(T);
+		}
+
+		void fail(const char* what) {
+			throw std::runtime_error(std::string("mapped_vector: ") + what);
+		}
+
+		void advise(void) {
+			if (front != nullptr) madvise(front, bytes(len_Vector), MADV_SEQUENTIAL);
+		}
+
+		// map n elems, extending the file first
+		void remap(int64_t n) {
+			if (!writable) fail("cannot grow a read_only mapping");
+			if (ftruncate(fd, bytes(n)) != 0) fail("ftruncate failed");
+			void* p;
+			if (front == nullptr) p = mmap(nullptr, bytes(n), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			else p = mremap(front, bytes(len_Vector), bytes(n), MREMAP_MAYMOVE);
+			if (p == MAP_FAILED) fail("mmap failed");
+			front = (T*)p;
+			len_Vector = n;
+			advise();
+		}
+
+		void close(void) {
+			if (front != nullptr) munmap(front, bytes(len_Vector));
+			if (fd >= 0) {
+				if (writable && ftruncate(fd, bytes(len_elem)) != 0) {} // trim the growth slack, nothing to do on failure
+				::close(fd);
+			}
+			front = nullptr;
+			fd = -1;
+			len_Vector = len_elem = 0;
+		}
+
+	public:
+		explicit mapped_vector(const std::string& path, open_mode mode = read_only) {
+			writable = (mode == read_write);
+			front = nullptr;
+			len_Vector = len_elem = 0;
+			fd = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+			if (fd < 0) fail("cannot open file");
+
+			struct stat st;
+			if (fstat(fd, &st) != 0) {
+				::close(fd);
+				fail("fstat failed");
+			}
+			len_elem = len_Vector = st.st_size / sizeof(T);
+			if (len_Vector > 0) {
+				int prot = PROT_READ | PROT_WRITE;
+				void* p = mmap(nullptr, bytes(len_Vector), prot, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+				if (p == MAP_FAILED) {
+					::close(fd);
+					fail("mmap failed");
+				}
+				front = (T*)p;
+				advise();
+			}
+		}
+
+		mapped_vector(const mapped_vector&) = delete;
+		mapped_vector& operator=(const mapped_vector&) = delete;
+
+		mapped_vector(mapped_vector&& m) : fd(m.fd), writable(m.writable), front(m.front), len_Vector(m.len_Vector), len_elem(m.len_elem) {
+			m.fd = -1;
+			m.front = nullptr;
+			m.len_Vector = m.len_elem = 0;
+		}
+
+		mapped_vector& operator=(mapped_vector&& m) {
+			if (this != &m) {
+				close();
+				fd = m.fd;
+				writable = m.writable;
+				front = m.front;
+				len_Vector = m.len_Vector;
+				len_elem = m.len_elem;
+				m.fd = -1;
+				m.front = nullptr;
+				m.len_Vector = m.len_elem = 0;
+			}
+			return *this;
+		}
+
+		~mapped_vector(void) {
+			close();
+		}
+
+		int64_t size(void) const {
+			return len_elem;
+		}
+
+		int64_t capacity(void) const {
+			return len_Vector;
+		}
+
+		T* data(void) {
+			return front;
+		}
+
+		const T* data(void) const {
+			return front;
+		}
+
+		T& operator[](int64_t k) {
+			if (k >= len_elem || k<0) throw std::out_of_range("Index out of range in mapped_vector[]");
+			return front[k];
+		}
+
+		const T& operator[](int64_t k) const {
+			if (k >= len_elem || k<0) throw std::out_of_range("Index out of range in mapped_vector[]");
+			return front[k];
+		}
+
+		T* begin(void) { return front; }
+		T* end(void) { return front + len_elem; }
+		const T* begin(void) const { return front; }
+		const T* end(void) const { return front + len_elem; }
+
+		void reserve(int64_t n) {
+			if (n > len_Vector) remap(n);
+		}
+
+		// shrinking keeps the mapping, growing exposes whatever the file holds there (zero bytes once extended)
+		void resize(int64_t n) {
+			if (n < 0) throw std::out_of_range("n<0 in resize");
+			if (n > len_Vector) remap(n);
+			len_elem = n;
+		}
+
+		void push_back(const T& e) {
+			if (len_elem == len_Vector) {
+				T temp{ e }; // e may refer to an elem, which is about to be remapped
+				int64_t n = Growth::grow(len_Vector, len_Vector + 1, sizeof(T));
+				remap((n < len_Vector + 1) ? len_Vector + 1 : n);
+				front[len_elem++] = temp;
+				return;
+			}
+			front[len_elem++] = e;
+		}
+
+		void pop_back(void) {
+			if (len_elem <= 0) throw std::out_of_range("Index out of range in pop_back");
+			len_elem--;
+		}
+
+		// flush the written pages to the file
+		void sync(void) {
+			if (writable && front != nullptr && msync(front, bytes(len_Vector), MS_SYNC) != 0) fail("msync failed");
+		}
+	};
+
+	template <typename T, typename Growth>
+	struct is_storage<mapped_vector<T, Growth>> : public std::true_type {};
+
+} //namespace zrdw
+
+#endif // __linux__
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef _RING_VECTOR_H_
+#define _RING_VECTOR_H_
+
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <utility>
+// zrdw::relocator, zrdw::heap_allocator
+#include "Vector.h"
+
+namespace zrdw {
+
+	/*
+	bounded ring-buffer mode of vector, for sliding windows.
+	the buffer is allocated once with a power-of-two length so that positions wrap with a mask,
+	push/pop at both ends are O(1) and never reallocate. once size() reaches bound(),
+	push_back drops the front elem and push_front drops the back elem
+	*/
+	template <typename T, typename Alloc = heap_allocator<T>>
+	class ring_vector {
+	private:
+		Alloc alloc;
+		T* head;
+		int64_t len_Vector; // power of two, >= len_bound
+		int64_t len_bound;
+		int64_t first; // position of the first elem in head
+		int64_t len_elem;
+
+		T* slot(int64_t k) const {
+			return head + ((first + k) & (len_Vector - 1));
+		}
+
+		void copy(const ring_vector& r) {
+			len_Vector = r.len_Vector;
+			len_bound = r.len_bound;
+			head = alloc.allocate(len_Vector);
+			first = 0;
+			len_elem = r.len_elem;
+			for (int64_t i = 0; i < len_elem; i++) {
+				new (head + i) T(*r.slot(i));
+			}
+		}
+
+		void destroy(void) {
+			clear();
+			alloc.deallocate(head, len_Vector);
+			head = nullptr;
+			len_Vector = len_bound = 0;
+		}
+
+	public:
+		explicit ring_vector(int64_t bound, const Alloc& a = Alloc()) : alloc(a) {
+			if (bound <= 0) throw std::out_of_range("In ring_vector constructor bound<=0");
+			len_Vector = 1;
+			while (len_Vector < bound) len_Vector <<= 1;
+			len_bound = bound;
+			head = alloc.allocate(len_Vector);
+			first = len_elem = 0;
+		}
+
+		ring_vector(const ring_vector& r) : alloc(r.alloc) {
+			copy(r);
+		}
+
+		ring_vector& operator=(const ring_vector& r) {
+			if (this != &r) {
+				destroy();
+				copy(r);
+			}
+			return *this;
+		}
+
+		ring_vector(ring_vector&& r) noexcept : alloc(r.alloc), head(r.head), len_Vector(r.len_Vector), len_bound(r.len_bound), first(r.first), len_elem(r.len_elem) {
+			r.head = nullptr;
+			r.len_Vector = r.len_bound = r.first = r.len_elem = 0;
+		}
+
+		ring_vector& operator=(ring_vector&& r) noexcept {
+			if (this != &r) {
+				destroy();
+				alloc = r.alloc;
+				head = r.head;
+				len_Vector = r.len_Vector;
+				len_bound = r.len_bound;
+				first = r.first;
+				len_elem = r.len_elem;
+				r.head = nullptr;
+				r.len_Vector = r.len_bound = r.first = r.len_elem = 0;
+			}
+			return *this;
+		}
+
+		~ring_vector(void) {
+			destroy();
+		}
+
+		int64_t size(void) const {
+			return len_elem;
+		}
+
+		int64_t bound(void) const {
+			return len_bound;
+		}
+
+		bool empty(void) const {
+			return len_elem == 0;
+		}
+
+		bool full(void) const {
+			return len_elem == len_bound;
+		}
+
+		T& operator[](int64_t k) {
+			if (k >= len_elem || k<0) throw std::out_of_range("Index out of range in ring_vector[]");
+			return *slot(k);
+		}
+
+		const T& operator[](int64_t k) const {
+			if (k >= len_elem || k<0) throw std::out_of_range("Index out of range in ring_vector[]");
+			return *slot(k);
+		}
+
+		/*
+		when full, the new elem is built aside before the elem at the other end is dropped, as e may be that elem;
+		a ctor that throws before the drop leaves the ring as it was, one moving it in afterwards leaves it one elem shorter
+		*/
+		void push_back(const T& e) {
+			if (len_elem == len_bound) {
+				push_back(T(e));
+				return;
+			}
+			new (slot(len_elem)) T(e);
+			len_elem++;
+		}
+
+		void push_back(T&& e) {
+			if (len_elem == len_bound) {
+				T temp(std::move(e));
+				pop_front();
+				new (slot(len_elem)) T(std::move(temp));
+			}
+			else {
+				new (slot(len_elem)) T(std::move(e));
+			}
+			len_elem++;
+		}
+
+		void push_front(const T& e) {
+			if (len_elem == len_bound) {
+				push_front(T(e));
+				return;
+			}
+			new (head + ((first - 1) & (len_Vector - 1))) T(e);
+			first = (first - 1) & (len_Vector - 1);
+			len_elem++;
+		}
+
+		void push_front(T&& e) {
+			if (len_elem == len_bound) {
+				T temp(std::move(e));
+				pop_back();
+				new (head + ((first - 1) & (len_Vector - 1))) T(std::move(temp));
+			}
+			else {
+				new (head + ((first - 1) & (len_Vector - 1))) T(std::move(e));
+			}
+			first = (first - 1) & (len_Vector - 1);
+			len_elem++;
+		}
+
+		void pop_back(void) {
+			if (len_elem <= 0) throw std::out_of_range("Index out of range in pop_back");
+			slot(len_elem - 1)->~T();
+			len_elem--;
+		}
+
+		void pop_front(void) {
+			if (len_elem <= 0) throw std::out_of_range("Index out of range in pop_front");
+			head[first].~T();
+			first = (first + 1) & (len_Vector - 1);
+			len_elem--;
+		}
+
+		void clear(void) {
+			for (int64_t i = 0; i < len_elem; i++) {
+				slot(i)->~T();
+			}
+			first = len_elem = 0;
+		}
+
+		// copy the window in order into raw storage at out, at most two contiguous runs
+		void copy_to(T* out) const {
+			int64_t run = len_Vector - first;
+			if (run > len_elem) run = len_elem;
+			relocator<T>::copy(out, (const T*) head + first, run);
+			relocator<T>::copy(out + run, (const T*) head, len_elem - run);
+		}
+	};
+
+} //namespace zrdw
+
+#endif
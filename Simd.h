@@ -0,0 +1,238 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include <cstdint>
+
+namespace zrdw {
+
+	/*
+	SIMD evaluation engine: runs out[i - first] = k(i) over an index range [first, last), where k is a kernel, a flattened
+	expression whose call inlines down to loads, arithmetic and a store (see kernel_of in Valarray.h).
+	the loop is compiled once per instruction set, with the target attribute, and the widest one
+	the CPU supports is picked at runtime through CPUID, so one binary runs on every x86-64 host:
+		avx512   64-byte packets (AVX-512F)
+		avx2     32-byte packets (AVX2 + FMA)
+		sse2     16-byte packets (x86-64 baseline)
+		generic  whatever the compiler flags allow, on other architectures and compilers
+	a head loop runs until out is aligned to the packet width, the body then runs in whole packets,
+	and a tail loop finishes the last elems. the body is written through a restrict pointer when k.apart()
+	says no operand overlaps out, so the compiler needs no alias versioning (which -O2 does not do);
+	otherwise it stays a plain loop, elem after elem.
+	reductions (fold, kahan_sum) run through the same dispatch, in several accumulators per packet width
+	*/
+	namespace simd {
+		enum isa { generic, sse2, avx2, avx512 };
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ZRDW_SIMD_X86 1
+#define ZRDW_SIMD_INLINE inline __attribute__((always_inline))
+#else
+#define ZRDW_SIMD_X86 0
+#define ZRDW_SIMD_INLINE inline
+#endif
+
+		inline isa detect(void) {
+#if ZRDW_SIMD_X86
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f")) return avx512;
+			if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return avx2;
+			return sse2;
+#else
+			return generic;
+#endif
+		}
+
+		inline isa& selected(void) {
+			static isa s = detect();
+			return s;
+		}
+
+		// the instruction set in use, detected once
+		inline isa current(void) {
+			return selected();
+		}
+
+		// force a narrower instruction set, e.g. to compare them; a wider one than detect() is ignored
+		inline void limit(isa i) {
+			selected() = (i < detect()) ? i : detect();
+		}
+
+		inline const char* name(isa i) {
+			switch (i) {
+			case avx512: return "avx512";
+			case avx2: return "avx2";
+			case sse2: return "sse2";
+			default: return "generic";
+			}
+		}
+
+		// [lo1, hi1) and [lo2, hi2) share no byte
+		inline bool disjoint(const void* lo1, const void* hi1, const void* lo2, const void* hi2) {
+			return (uintptr_t)hi1 <= (uintptr_t)lo2 || (uintptr_t)hi2 <= (uintptr_t)lo1;
+		}
+
+		// n elems in whole packets of Width, out[j] = k(first + j); the fixed trip count of the inner loop lets -O2 vectorize it without an epilogue
+		template <int64_t Width, typename T, typename K>
+		ZRDW_SIMD_INLINE void unaliased(T* __restrict out, const K& k, int64_t first, int64_t n) {
+			for (int64_t j = 0; j < n; j += Width) {
+				for (int64_t l = j; l < j + Width; l++) out[l] = k(first + l);
+			}
+		}
+
+		// head, whole packets of Bytes, tail
+		template <int64_t Bytes, typename T, typename K>
+		ZRDW_SIMD_INLINE void packets(T* out, const K& k, int64_t first, int64_t last) {
+			constexpr int64_t width = (Bytes / (int64_t)sizeof(T) > 0) ? Bytes / (int64_t)sizeof(T) : 1;
+			int64_t n = last - first, j = 0;
+			if (Bytes % sizeof(T) == 0 && (uintptr_t)out % sizeof(T) == 0) {
+				for (; j < n && (uintptr_t)(out + j) % Bytes != 0; j++) out[j] = k(first + j);
+			}
+			int64_t body = j + (n - j) / width * width;
+			if (j < body && k.apart(out + j, first + j, first + body)) {
+				unaliased<width>(out + j, k, first + j, body - j);
+				j = body;
+			}
+			for (; j < n; j++) out[j] = k(first + j);
+		}
+
+		// a[0] = a[0] op a[1] op ... op a[n - 1], combined pairwise
+		template <typename T, typename Op>
+		ZRDW_SIMD_INLINE T join(T* a, int64_t n, Op op) {
+			for (int64_t w = n; w > 1;) {
+				int64_t h = (w + 1) / 2;
+				for (int64_t j = 0; j < w - h; j++) a[j] = op(a[j], a[j + h]);
+				w = h;
+			}
+			return a[0];
+		}
+
+		/*
+		fold of k(i) over [first, last), first < last, in Lanes accumulators stepped side by side:
+		the ops of one step do not wait on each other and vectorize, without reassociating any lane.
+		the lanes are then joined pairwise
+		*/
+		template <int64_t Lanes, typename T, typename K, typename Op>
+		ZRDW_SIMD_INLINE T lanes(const K& k, int64_t first, int64_t last, Op op) {
+			if (last - first < 2*Lanes) {
+				T acc = k(first);
+				for (int64_t i = first + 1; i < last; i++) acc = op(acc, k(i));
+				return acc;
+			}
+			T acc[Lanes];
+			for (int64_t j = 0; j < Lanes; j++) acc[j] = k(first + j);
+			int64_t i = first + Lanes;
+			int64_t body = first + (last - first) / Lanes * Lanes;
+			for (; i < body; i += Lanes) {
+				for (int64_t j = 0; j < Lanes; j++) acc[j] = op(acc[j], k(i + j));
+			}
+			for (; i < last; i++) acc[0] = op(acc[0], k(i));
+			return join(acc, Lanes, op);
+		}
+
+		// Kahan sum of k(i) over [first, last), one compensation per lane, lanes joined by a compensated sum
+		template <int64_t Lanes, typename T, typename K>
+		ZRDW_SIMD_INLINE T compensated(const K& k, int64_t first, int64_t last) {
+			T s[Lanes], c[Lanes];
+			for (int64_t j = 0; j < Lanes; j++) s[j] = c[j] = T();
+			int64_t i = first;
+			int64_t body = first + (last - first) / Lanes * Lanes;
+			for (; i < body; i += Lanes) {
+				for (int64_t j = 0; j < Lanes; j++) {
+					T y = k(i + j) - c[j];
+					T t = s[j] + y;
+					c[j] = (t - s[j]) - y;
+					s[j] = t;
+				}
+			}
+			T sum = T(), comp = T();
+			for (int64_t j = 0; j < Lanes + (last - i); j++) {
+				T y = ((j < Lanes) ? s[j] - c[j] : k(i + j - Lanes)) - comp;
+				T t = sum + y;
+				comp = (t - sum) - y;
+				sum = t;
+			}
+			return sum;
+		}
+
+		// accumulators per fold: 4 packets, so that 4 independent ops are in flight
+		template <int64_t Bytes, typename T>
+		struct lanes_of { static constexpr int64_t value = 4*((Bytes / (int64_t)sizeof(T) > 0) ? Bytes / (int64_t)sizeof(T) : 1); };
+
+		// the loops as jobs: go<Bytes>() runs one for packets of Bytes
+		template <typename T, typename K>
+		struct store_job {
+			T* out;
+			K k;
+			int64_t first, last;
+			template <int64_t Bytes> ZRDW_SIMD_INLINE void go(void) const { packets<Bytes>(out, k, first, last); }
+		};
+
+		template <typename T, typename K, typename Op>
+		struct fold_job {
+			K k;
+			int64_t first, last;
+			Op op;
+			template <int64_t Bytes> ZRDW_SIMD_INLINE T go(void) const { return lanes<lanes_of<Bytes, T>::value, T>(k, first, last, op); }
+		};
+
+		template <typename T, typename K>
+		struct kahan_job {
+			K k;
+			int64_t first, last;
+			template <int64_t Bytes> ZRDW_SIMD_INLINE T go(void) const { return compensated<lanes_of<Bytes, T>::value, T>(k, first, last); }
+		};
+
+#if ZRDW_SIMD_X86
+		template <typename Job>
+		__attribute__((target("avx512f,avx2,fma"))) auto on_avx512(Job job) -> decltype(job.template go<64>()) {
+			return job.template go<64>();
+		}
+
+		template <typename Job>
+		__attribute__((target("avx2,fma"))) auto on_avx2(Job job) -> decltype(job.template go<32>()) {
+			return job.template go<32>();
+		}
+#endif
+
+		template <typename Job>
+		auto on_baseline(Job job) -> decltype(job.template go<16>()) {
+			return job.template go<16>();
+		}
+
+		// job.go<Bytes>() compiled for, and run with, the instruction set in use
+		template <typename Job>
+		auto dispatch(const Job& job) -> decltype(job.template go<16>()) {
+#if ZRDW_SIMD_X86
+			switch (current()) {
+			case avx512: return on_avx512(job);
+			case avx2: return on_avx2(job);
+			default: break;
+			}
+#endif
+			return on_baseline(job);
+		}
+
+		// out[i - first] = k(i) for i in [first, last): out holds the elem of index first
+		template <typename T, typename K>
+		void run(T* out, const K& k, int64_t first, int64_t last) {
+			if (first >= last) return;
+			dispatch(store_job<T, K>{ out, k, first, last });
+		}
+
+		// k(first) op k(first + 1) op ... op k(last - 1), op associative, first < last
+		template <typename T, typename K, typename Op>
+		T fold(const K& k, int64_t first, int64_t last, Op op) {
+			return dispatch(fold_job<T, K, Op>{ k, first, last, op });
+		}
+
+		// compensated sum of k(i) over [first, last)
+		template <typename T, typename K>
+		T kahan_sum(const K& k, int64_t first, int64_t last) {
+			if (first >= last) return T();
+			return dispatch(kahan_job<T, K>{ k, first, last });
+		}
+	}
+
+} //namespace zrdw
+
+#endif
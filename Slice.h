@@ -0,0 +1,219 @@
+#ifndef _SLICE_H_
+#define _SLICE_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+// zrdw::span, zrdw::is_storage, zrdw::is_view
+#include "Span.h"
+
+#if defined(__GNUC__)
+#define ZRDW_PREFETCH(p, rw) __builtin_prefetch((p), (rw))
+#else
+#define ZRDW_PREFETCH(p, rw) ((void)0)
+#endif
+
+namespace zrdw {
+
+	/*
+	selectors of valarray views, as std::slice and std::gslice:
+		v[slice(1, n, 2)]                           n elems from v[1], every 2nd, a strided span
+		v[gslice(0, {rows, cols}, {ld, 1})]         a rows x cols block of a matrix stored with leading dimension ld
+		v.mask(m)                                   the elems where m (any array of bool or numbers) is nonzero
+		v.indirect(idx)                             v[idx[0]], v[idx[1]], ...
+	see valarray::operator[] in Valarray.h
+	*/
+	class slice {
+	private:
+		int64_t first, len_elem, step_elem;
+
+	public:
+		slice(void) : first(0), len_elem(0), step_elem(1) {}
+
+		slice(int64_t start, int64_t n, int64_t step) : first(start), len_elem(n), step_elem(step) {
+			if (start < 0 || n < 0) throw std::out_of_range("start<0 or n<0 in slice constructor");
+			if (step <= 0) throw std::out_of_range("stride<=0 in slice constructor");
+		}
+
+		int64_t start(void) const { return first; }
+		int64_t size(void) const { return len_elem; }
+		int64_t stride(void) const { return step_elem; }
+	};
+
+	// elem i, written in the mixed radix of lengths (last dimension fastest), is at start + sum of digit*stride
+	class gslice {
+	private:
+		int64_t first;
+		std::vector<int64_t> lens, steps;
+
+	public:
+		gslice(void) : first(0) {}
+
+		gslice(int64_t start, std::vector<int64_t> lengths, std::vector<int64_t> strides) : first(start), lens(std::move(lengths)), steps(std::move(strides)) {
+			if (start < 0) throw std::out_of_range("start<0 in gslice constructor");
+			if (lens.size() != steps.size()) throw std::out_of_range("lengths and strides differ in size in gslice constructor");
+			for (size_t d = 0; d < lens.size(); d++) {
+				if (lens[d] < 0 || steps[d] < 0) throw std::out_of_range("negative length or stride in gslice constructor");
+			}
+		}
+
+		int64_t start(void) const { return first; }
+		const std::vector<int64_t>& size(void) const { return lens; }
+		const std::vector<int64_t>& stride(void) const { return steps; }
+
+		int64_t count(void) const {
+			int64_t n = lens.empty() ? 0 : 1;
+			for (int64_t l : lens) n *= l;
+			return n;
+		}
+	};
+
+	/*
+	non-owning view of the elems p[at[0]], p[at[1]], ..., the storage behind gslice, mask and indirect views.
+	the offsets are computed once and shared between copies, so views copy in O(1) into expressions.
+	reads through it gather, in SIMD gathers where the ISA has them; writes scatter, prefetching the elem
+	prefetch_distance positions ahead, for which the table carries that many copies of its last offset past the end.
+	offsets may repeat; assigning through such a view writes the repeated elem more than once, the last write wins.
+	as span, it can shrink but not grow
+	*/
+	template <typename T>
+	class index_span {
+	public:
+		static constexpr int64_t prefetch_distance = 16;
+
+	private:
+		struct table {
+			std::vector<int64_t> at; // size() + prefetch_distance offsets
+			int64_t lo, hi; // smallest and largest offset, hi < lo when empty
+			bool ascending; // each offset above the one before, so no elem is selected twice
+		};
+
+		T* front;
+		std::shared_ptr<const table> offsets;
+		int64_t len_elem;
+
+	public:
+		using value_type = T;
+
+		index_span(void) : front(nullptr), len_elem(0) {}
+
+		// offsets must be >= 0 and point into the buffer at p
+		index_span(T* p, std::vector<int64_t> at) : front(p), len_elem(static_cast<int64_t>(at.size())) {
+			std::shared_ptr<table> t = std::make_shared<table>();
+			t->lo = std::numeric_limits<int64_t>::max();
+			t->hi = -1;
+			t->ascending = true;
+			for (int64_t k : at) {
+				if (k < 0) throw std::out_of_range("negative offset in index_span constructor");
+				if (k <= t->hi) t->ascending = false;
+				if (k < t->lo) t->lo = k;
+				if (k > t->hi) t->hi = k;
+			}
+			at.resize(at.size() + prefetch_distance, at.empty() ? 0 : at.back());
+			t->at = std::move(at);
+			offsets = std::move(t);
+		}
+
+		int64_t size(void) const {
+			return len_elem;
+		}
+
+		T* data(void) const {
+			return front;
+		}
+
+		const int64_t* index(void) const {
+			return offsets ? offsets->at.data() : nullptr;
+		}
+
+		int64_t lowest(void) const {
+			return offsets ? offsets->lo : 0;
+		}
+
+		int64_t highest(void) const {
+			return offsets ? offsets->hi : -1;
+		}
+
+		bool ascending(void) const {
+			return !offsets || offsets->ascending;
+		}
+
+		T& operator[](int64_t k) const {
+			if (k >= len_elem || k<0) throw std::out_of_range("Index out of range in index_span[]");
+			return front[offsets->at[k]];
+		}
+
+		// only shrinking, lowest() and highest() keep bounding the whole table
+		void resize(int64_t n) {
+			if (n < 0 || n > len_elem) throw std::out_of_range("index_span cannot grow in resize");
+			len_elem = n;
+		}
+	};
+
+	template <typename T>
+	struct is_storage<index_span<T>> : public std::true_type {};
+
+	template <typename T>
+	struct is_view<index_span<T>> : public std::true_type {};
+
+	namespace zrdw_hide {
+		/*
+		offsets of the selected elems in a buffer of n elems spaced step apart, scaled by step,
+		after checking that every selected elem is one of the n
+		*/
+		inline std::vector<int64_t> offsets_of_gslice(const gslice& g, int64_t n, int64_t step) {
+			const std::vector<int64_t>& lens = g.size();
+			const std::vector<int64_t>& strides = g.stride();
+			int64_t count = g.count();
+			std::vector<int64_t> at;
+			if (count == 0) return at;
+			int64_t last = g.start();
+			for (size_t d = 0; d < lens.size(); d++) last += (lens[d] - 1)*strides[d];
+			if (last >= n) throw std::out_of_range("gslice out of range of valarray");
+			at.reserve(count);
+			std::vector<int64_t> digit(lens.size(), 0);
+			int64_t dims = static_cast<int64_t>(lens.size());
+			int64_t inner = lens[dims - 1], inner_stride = strides[dims - 1]*step;
+			for (int64_t row = g.start()*step; static_cast<int64_t>(at.size()) < count;) { // odometer over the outer dimensions
+				for (int64_t j = 0; j < inner; j++) at.push_back(row + j*inner_stride);
+				int64_t d = dims - 2;
+				for (; d >= 0 && ++digit[d] == lens[d]; d--) {
+					digit[d] = 0;
+					row -= (lens[d] - 1)*strides[d]*step;
+				}
+				if (d < 0) break;
+				row += strides[d]*step;
+			}
+			return at;
+		}
+
+		template <typename M>
+		std::vector<int64_t> offsets_of_mask(const M& m, int64_t n, int64_t step) {
+			if (static_cast<int64_t>(m.size()) != n) throw std::out_of_range("mask and valarray differ in size");
+			std::vector<int64_t> at;
+			for (int64_t i = 0; i < n; i++) {
+				if (m[i]) at.push_back(i*step);
+			}
+			return at;
+		}
+
+		template <typename I>
+		std::vector<int64_t> offsets_of_indirect(const I& idx, int64_t n, int64_t step) {
+			int64_t count = idx.size();
+			std::vector<int64_t> at(count);
+			for (int64_t i = 0; i < count; i++) {
+				int64_t k = static_cast<int64_t>(idx[i]);
+				if (k < 0 || k >= n) throw std::out_of_range("Index out of range in indirect");
+				at[i] = k*step;
+			}
+			return at;
+		}
+	}
+
+} //namespace zrdw
+
+#endif
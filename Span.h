@@ -0,0 +1,143 @@
+#ifndef _SPAN_H_
+#define _SPAN_H_
+
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+// zrdw::vector, zrdw::is_storage
+#include "Vector.h"
+
+namespace zrdw {
+
+	/*
+	non-owning view of n elems spaced stride apart, starting at p.
+	it plugs in as the Expr of valarray, so external buffers (sockets, mmap, other libraries)
+	take part in expressions without being copied into a vector first:
+		valarray<double, span<double>> a(span<double>(buf, n));
+		valarray<double> c = a*2.0 + b;
+	and views into a vector select sub-ranges or every stride-th elem:
+		valarray<double, span<double>> odd(span<double>(v, 1, v.size()/2, 2));
+	the viewed buffer must outlive the span, and is never resized or freed by it.
+	a span can shrink (assignment of a shorter valarray does) but not grow
+	*/
+	template <typename T>
+	class span {
+	private:
+		T* front;
+		int64_t len_elem;
+		int64_t stride;
+
+	public:
+		using value_type = T;
+
+		span(void) : front(nullptr), len_elem(0), stride(1) {}
+
+		span(T* p, int64_t n, int64_t step = 1) : front(p), len_elem(n), stride(step) {
+			if (n < 0) throw std::out_of_range("n<0 in span constructor");
+			if (step <= 0) throw std::out_of_range("stride<=0 in span constructor");
+		}
+
+		// view of elems first, first+step, ... of v, n of them, n = -1 takes as many as fit
+		template <typename Check, typename Alloc, typename Growth>
+		span(vector<T, Check, Alloc, Growth>& v, int64_t first = 0, int64_t n = -1, int64_t step = 1) : stride(step) {
+			if (step <= 0) throw std::out_of_range("stride<=0 in span constructor");
+			if (first < 0 || first > v.size()) throw std::out_of_range("Index out of range in span constructor");
+			int64_t fit = (v.size() - first + step - 1) / step;
+			if (n < 0) n = fit;
+			if (n > fit) throw std::out_of_range("Index out of range in span constructor");
+			len_elem = n;
+			front = (n == 0) ? nullptr : &v[first];
+		}
+
+		int64_t size(void) const {
+			return len_elem;
+		}
+
+		int64_t step(void) const {
+			return stride;
+		}
+
+		T* data(void) const {
+			return front;
+		}
+
+		bool contiguous(void) const {
+			return stride == 1;
+		}
+
+		T& operator[](int64_t k) const {
+			if (k >= len_elem || k<0) throw std::out_of_range("Index out of range in span[]");
+			return front[k*stride];
+		}
+
+		// sub-view of this view, indices and step relative to it
+		span subspan(int64_t first, int64_t n = -1, int64_t step = 1) const {
+			if (step <= 0) throw std::out_of_range("stride<=0 in subspan");
+			if (first < 0 || first > len_elem) throw std::out_of_range("Index out of range in subspan");
+			int64_t fit = (len_elem - first + step - 1) / step;
+			if (n < 0) n = fit;
+			if (n > fit) throw std::out_of_range("Index out of range in subspan");
+			return span((n == 0) ? nullptr : front + first*stride, n, stride*step);
+		}
+
+		// only shrinking, the span cannot allocate
+		void resize(int64_t n) {
+			if (n < 0 || n > len_elem) throw std::out_of_range("span cannot grow in resize");
+			len_elem = n;
+		}
+
+		// base pointer and elem index, so that end() of a strided span never points past the viewed buffer
+		class iterator {
+		public:
+			using difference_type = int64_t;
+			using value_type = T;
+			using iterator_category = std::random_access_iterator_tag;
+			using pointer = T*;
+			using reference = T&;
+
+			T* base;
+			int64_t idx;
+			int64_t stride;
+
+			iterator(T* _base, int64_t _idx, int64_t _stride) : base(_base), idx(_idx), stride(_stride) {}
+
+			T& operator*(void) const { return base[idx*stride]; }
+			T* operator->(void) const { return base + idx*stride; }
+			T& operator[](int64_t k) const { return base[(idx + k)*stride]; }
+
+			iterator& operator++(void) { ++idx; return *this; }
+			iterator operator++(int) { iterator temp(*this); ++idx; return temp; }
+			iterator& operator--(void) { --idx; return *this; }
+			iterator operator--(int) { iterator temp(*this); --idx; return temp; }
+			iterator& operator+=(int64_t k) { idx += k; return *this; }
+			iterator& operator-=(int64_t k) { idx -= k; return *this; }
+			iterator operator+(int64_t k) const { return iterator(base, idx + k, stride); }
+			iterator operator-(int64_t k) const { return iterator(base, idx - k, stride); }
+			friend iterator operator+(int64_t k, const iterator& it) { return it + k; }
+			int64_t operator-(const iterator& it) const { return idx - it.idx; }
+
+			bool operator==(const iterator& it) const { return idx == it.idx; }
+			bool operator!=(const iterator& it) const { return idx != it.idx; }
+			bool operator<(const iterator& it) const { return idx < it.idx; }
+			bool operator>(const iterator& it) const { return idx > it.idx; }
+			bool operator<=(const iterator& it) const { return idx <= it.idx; }
+			bool operator>=(const iterator& it) const { return idx >= it.idx; }
+		};
+
+		iterator begin(void) const { return iterator(front, 0, stride); }
+		iterator end(void) const { return iterator(front, len_elem, stride); }
+	};
+
+	template <typename T>
+	struct is_storage<span<T>> : public std::true_type {};
+
+	//views are storage that does not own its elems: cheap to copy, so expressions hold them by copy, not by reference
+	template <typename E>
+	struct is_view : public std::false_type {};
+	template <typename T>
+	struct is_view<span<T>> : public std::true_type {};
+
+} //namespace zrdw
+
+#endif
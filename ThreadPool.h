@@ -0,0 +1,263 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace zrdw {
+
+	/*
+	persistent thread pool for chunked loops: parallel_for(n, grain, f) calls f(first, last) over [0, n)
+	in chunks of grain indices, on the workers and the calling thread, and returns once all chunks are done.
+	each participant starts with an equal run of chunks and takes them from its front;
+	when its run is empty it steals the back half of the largest run left, so uneven chunks even out
+	without a shared queue. one loop runs at a time, a parallel_for called from inside a chunk runs inline.
+	the first exception thrown by f is rethrown by parallel_for, chunks not yet started are then skipped
+	*/
+	class thread_pool {
+		struct alignas(64) run { // chunks [lo, hi) of one participant
+			std::mutex lock;
+			int64_t lo = 0, hi = 0;
+		};
+
+		std::vector<std::thread> workers;
+		std::unique_ptr<run[]> runs; // workers.size() + 1, the last for the calling thread
+
+		std::mutex job_lock; // one parallel_for at a time
+		std::mutex lock; // guards generation, busy, stop
+		std::condition_variable wake, idle;
+		uint64_t generation = 0;
+		int busy = 0;
+		bool stop = false;
+
+		// the loop in progress
+		void (*call)(void*, int64_t, int64_t) = nullptr;
+		void* body = nullptr;
+		int64_t len = 0, grain = 1;
+		std::atomic<bool> failed{ false };
+		std::exception_ptr error;
+
+		static bool& inside(void) {
+			static thread_local bool in_chunk = false;
+			return in_chunk;
+		}
+
+		int64_t take(int self) {
+			run& r = runs[self];
+			std::lock_guard<std::mutex> guard(r.lock);
+			return (r.lo < r.hi) ? r.lo++ : -1;
+		}
+
+		// move the back half of the largest run to self, return its first chunk
+		int64_t steal(int self) {
+			int parts = (int)workers.size() + 1;
+			for (;;) {
+				int victim = -1;
+				int64_t most = 0;
+				for (int k = 0; k < parts; k++) {
+					if (k == self) continue;
+					run& r = runs[k];
+					std::lock_guard<std::mutex> guard(r.lock);
+					if (r.hi - r.lo > most) {
+						most = r.hi - r.lo;
+						victim = k;
+					}
+				}
+				if (victim < 0) return -1; // runs only shrink, so every chunk is taken
+				int64_t lo, hi;
+				{
+					run& r = runs[victim];
+					std::lock_guard<std::mutex> guard(r.lock);
+					if (r.lo >= r.hi) continue; // emptied meanwhile, look again
+					lo = r.hi - (r.hi - r.lo + 1) / 2;
+					hi = r.hi;
+					r.hi = lo;
+				}
+				run& mine = runs[self];
+				std::lock_guard<std::mutex> guard(mine.lock);
+				mine.lo = lo + 1;
+				mine.hi = hi;
+				return lo;
+			}
+		}
+
+		void participate(int self) {
+			inside() = true;
+			for (;;) {
+				int64_t c = take(self);
+				if (c < 0) c = steal(self);
+				if (c < 0) break;
+				if (failed.load(std::memory_order_relaxed)) continue;
+				int64_t first = c*grain;
+				int64_t last = (len - first < grain) ? len : first + grain;
+				try {
+					call(body, first, last);
+				}
+				catch (...) {
+					if (!failed.exchange(true)) error = std::current_exception();
+				}
+			}
+			inside() = false;
+		}
+
+		void work(int self) {
+			uint64_t seen = 0;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> guard(lock);
+					wake.wait(guard, [&] { return stop || generation != seen; });
+					if (stop) return;
+					seen = generation;
+				}
+				participate(self);
+				std::lock_guard<std::mutex> guard(lock);
+				if (--busy == 0) idle.notify_one();
+			}
+		}
+
+		template <typename F>
+		static void invoke(void* f, int64_t first, int64_t last) {
+			(*static_cast<F*>(f))(first, last);
+		}
+
+	public:
+		// threads counts the calling thread, so threads - 1 workers are started; 0 takes the hardware concurrency
+		explicit thread_pool(int threads = 0) {
+			if (threads < 0) throw std::out_of_range("threads<0 in thread_pool constructor");
+			if (threads == 0) threads = std::max(1, (int)std::thread::hardware_concurrency());
+			runs.reset(new run[threads]);
+			workers.reserve(threads - 1);
+			for (int k = 0; k < threads - 1; k++) workers.emplace_back(&thread_pool::work, this, k);
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		~thread_pool(void) {
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				stop = true;
+			}
+			wake.notify_all();
+			for (std::thread& t : workers) t.join();
+		}
+
+		// participants in a loop, the calling thread included
+		int size(void) const {
+			return (int)workers.size() + 1;
+		}
+
+		// f(first, last) for the chunks [k*grain, min(n, (k+1)*grain)) of [0, n)
+		template <typename F>
+		void parallel_for(int64_t n, int64_t chunk, F&& f) {
+			if (n <= 0) return;
+			if (chunk <= 0) throw std::out_of_range("grain<=0 in parallel_for");
+			int64_t chunks = (n + chunk - 1) / chunk;
+			if (workers.empty() || chunks == 1 || inside()) {
+				for (int64_t first = 0; first < n; first += chunk) f(first, (n - first < chunk) ? n : first + chunk);
+				return;
+			}
+			std::lock_guard<std::mutex> serial(job_lock);
+			using G = typename std::remove_reference<F>::type;
+			call = &invoke<G>;
+			body = (void*)&f;
+			len = n;
+			grain = chunk;
+			failed.store(false, std::memory_order_relaxed);
+			error = nullptr;
+			int parts = size();
+			for (int k = 0; k < parts; k++) { // equal runs, no participant has started yet
+				runs[k].lo = chunks*k / parts;
+				runs[k].hi = chunks*(k + 1) / parts;
+			}
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				busy = (int)workers.size();
+				generation++;
+			}
+			wake.notify_all();
+			participate(parts - 1);
+			std::unique_lock<std::mutex> guard(lock);
+			idle.wait(guard, [&] { return busy == 0; });
+			if (error) std::rethrow_exception(error);
+		}
+	};
+
+	/*
+	parallel evaluation mode of valarray, off by default: with threads() > 1, expressions of at least
+	min_size() elems are evaluated in chunks of grain_bytes() of output on a shared thread_pool.
+		zrdw::parallel::set_threads(0);      // all hardware threads
+		zrdw::parallel::set_grain_bytes(1 << 16);
+	*/
+	namespace parallel {
+		struct settings {
+			int threads = 1;
+			int64_t grain_bytes = 1 << 16; // output bytes per chunk, about half an L2
+			int64_t min_size = 1 << 15; // smaller expressions stay on the calling thread
+			std::unique_ptr<thread_pool> pool;
+			std::mutex lock;
+		};
+
+		inline settings& config(void) {
+			static settings s;
+			return s;
+		}
+
+		inline int threads(void) {
+			return config().threads;
+		}
+
+		// threads taking part in evaluation, the calling one included; 0 takes the hardware concurrency, 1 turns the mode off.
+		// not to be called while an evaluation is running
+		inline void set_threads(int n) {
+			if (n < 0) throw std::out_of_range("threads<0 in set_threads");
+			settings& s = config();
+			std::lock_guard<std::mutex> guard(s.lock);
+			if (n == 0) n = std::max(1, (int)std::thread::hardware_concurrency());
+			if (n == s.threads && (n == 1 || s.pool)) return;
+			s.pool.reset();
+			s.threads = n;
+			if (n > 1) s.pool.reset(new thread_pool(n));
+		}
+
+		inline int64_t grain_bytes(void) {
+			return config().grain_bytes;
+		}
+
+		inline void set_grain_bytes(int64_t bytes) {
+			if (bytes <= 0) throw std::out_of_range("grain<=0 in set_grain_bytes");
+			config().grain_bytes = bytes;
+		}
+
+		inline int64_t min_size(void) {
+			return config().min_size;
+		}
+
+		inline void set_min_size(int64_t n) {
+			config().min_size = n;
+		}
+
+		// grain in elems of Bytes each, rounded to whole 64-byte lines so that chunks never share one
+		inline int64_t grain_elems(int64_t bytes) {
+			int64_t g = grain_bytes() / bytes;
+			int64_t line = (bytes < 64) ? 64 / bytes : 1;
+			g = (g + line - 1) / line * line;
+			return (g > 0) ? g : line;
+		}
+
+		inline thread_pool* pool(void) {
+			return config().pool.get();
+		}
+	}
+
+} //namespace zrdw
+
+#endif
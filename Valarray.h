@@ -18,6 +18,14 @@
 #include <vector>
 // zrdw::vector
 #include "Vector.h"
+// zrdw::simd::run
+#include "Simd.h"
+// zrdw::thread_pool, zrdw::parallel
+#include "ThreadPool.h"
+// zrdw::fastmath
+#include "FastMath.h"
+// zrdw::span, zrdw::slice, zrdw::gslice, zrdw::index_span
+#include "Slice.h"
 
 namespace zrdw {
 	//using std::vector; //during development and testing
@@ -26,6 +34,14 @@ namespace zrdw {
 	template <typename T, typename Expr> //prototype declared here, defined later
 	struct valarray;
 
+	/*
+	how sum() adds, from the most accurate to the fastest:
+		kahan     compensated, error independent of the length, about twice the cost of pairwise
+		pairwise  (default) halves down to blocks of 1024 summed in lanes, error grows as log n
+		naive     one pass in lanes, error grows as n / lanes
+	*/
+	enum class summation { pairwise, kahan, naive };
+
 	//namespace zrdw_hide(my uteid) hides all supporting templates, structs, etc from outside users
 	namespace zrdw_hide {
 		using namespace std::rel_ops;
@@ -99,11 +115,27 @@ namespace zrdw {
 		*/
 		template <typename T>
 		struct choose_operand_type { using type = const T; };
-		template <typename T>
-		struct choose_operand_type<valarray<T, vector<T>>> { using type = const vector<T>&; };
+		template <typename T, typename Expr> //storage (vector, mapped_vector, ...) by reference, Proxy and views (span, ...) by copy
+		struct choose_operand_type<valarray<T, Expr>> {
+			using type = typename std::conditional<is_storage<Expr>::value && !is_view<Expr>::value, const Expr&, const valarray<T, Expr>>::type;
+		};
 		template <typename T> //using copy, scalar is temp created by operator functions
 		struct choose_operand_type<scalar<T>> { using type = const scalar<T>; };
 
+		/*
+		type of the elems a Proxy yields: Operation::result_type when it declares one (std::plus, Sqrt, Exp, ...),
+		else whatever calling it on the operands' elems returns, so that lambdas work as well
+		*/
+		template <typename Operation, typename T1, typename T2>
+		struct invoke_type { using type = typename std::decay<decltype(std::declval<const Operation&>()(std::declval<const T1&>(), std::declval<const T2&>()))>::type; };
+		template <typename Operation, typename T1>
+		struct invoke_type<Operation, T1, emptyOperand> { using type = typename std::decay<decltype(std::declval<const Operation&>()(std::declval<const T1&>()))>::type; };
+
+		template <typename Operation, typename T1, typename T2, typename = void>
+		struct op_result { using type = typename invoke_type<Operation, T1, T2>::type; };
+		template <typename Operation, typename T1, typename T2>
+		struct op_result<Operation, T1, T2, typename std::conditional<true, void, typename Operation::result_type>::type> { using type = typename Operation::result_type; };
+
 		/*
 		full-functionalities random-access iterator template for proxy, should be const_iterator
 		*/
@@ -215,7 +247,7 @@ namespace zrdw {
 			using T1 = typename Left::value_type;
 			using T2 = typename Right::value_type;
 			using value_type = typename choose_type<T1, T2>::type; // may differ from result_type
-			using result_type = typename Operation::result_type; //result type after apply operation
+			using result_type = typename op_result<Operation, T1, T2>::type; //result type after apply operation
 			using L = typename choose_operand_type<Left>::type;
 			using R = typename choose_operand_type<Right>::type;
 
@@ -308,9 +340,414 @@ namespace zrdw {
 		//short form of enable_if
 		template <int f, typename T1, typename T2>
 		using Enable_if = typename enable_if<is_val_maths<T1, T2>::value, typename maths_retType<f, T1, T2>::retType>::type;
+
+		/*
+		kernels flatten an expression tree for the SIMD engine: storage becomes a raw pointer (with a stride for views),
+		a scalar its value, a Proxy its functor over the kernels of its operands. k(i) then inlines down to
+		loads and arithmetic, with no bounds check, no size() recursion and no copy of the operands.
+		k.apart(out, first, last) tells whether out[0, last - first) can take k(first), ..., k(last - 1) while k reads:
+		true when no operand overlaps it, or one reads exactly the elem being written (a = a*2);
+		the engine then skips its own alias checks. k.apart(t) answers the same for k(0), ..., k(t.n - 1) stored through
+		a strided or gather view t, where an operand can read an elem already written (b = b.indirect(rev)).
+		Mode, picked at runtime from the operands by with_kernel, specializes the kernel: unit_reads reads strided views
+		as contiguous, for when all of them have stride 1 (see unit_strides), small_trig evaluates sin and cos on the
+		short reduction, for when all their arguments are within fastmath::huge_reduced (see trig_args)
+		*/
+		constexpr int unit_reads = 1, small_trig = 2;
+
+		//the n elems a strided or gather view writes, p[i*stride] or p[at[i]], all within p[lo, hi]
+		template <typename T>
+		struct store_target {
+			const T* p;
+			int64_t stride;
+			const int64_t* at;
+			int64_t lo, hi, n;
+		};
+
+		template <typename N, typename = void> struct has_data : public std::false_type {};
+		template <typename N> struct has_data<N, decltype((void)std::declval<const N&>().data())> : public std::true_type {};
+		template <typename N, typename = void> struct has_step : public std::false_type {};
+		template <typename N> struct has_step<N, decltype((void)std::declval<const N&>().step())> : public std::true_type {};
+		template <typename N, typename = void> struct has_index : public std::false_type {};
+		template <typename N> struct has_index<N, decltype((void)std::declval<const N&>().index())> : public std::true_type {};
+
+		//storage whose elems are contiguous from data()
+		template <typename N>
+		struct is_contiguous { static constexpr bool value = is_storage<N>::value && has_data<N>::value && !has_step<N>::value && !has_index<N>::value; };
+
+		//storage whose elems are evenly spaced from data(), contiguous or strided: what slices, gslices, masks and indirects select from
+		template <typename N>
+		struct is_linear { static constexpr bool value = is_contiguous<N>::value || (is_storage<N>::value && has_step<N>::value); };
+
+		template <typename Node, int Mode = 0, typename = void>
+		struct kernel_of { //any other node, through its operator[]
+			using value_type = typename std::decay<decltype(std::declval<const Node&>()[0])>::type;
+			struct type {
+				const Node* node;
+				ZRDW_SIMD_INLINE value_type operator()(int64_t k) const { return (*node)[k]; }
+				template <typename U> bool apart(const U*, int64_t, int64_t) const { return false; } //unknown reads
+				template <typename U> bool apart(const store_target<U>&) const { return false; }
+			};
+			static type make(const Node& n) { return type{ &n }; }
+		};
+
+		template <typename Node, int Mode>
+		struct kernel_of<Node, Mode, typename std::enable_if<is_contiguous<Node>::value>::type> {
+			using value_type = typename std::remove_cv<typename std::remove_pointer<decltype(std::declval<const Node&>().data())>::type>::type;
+			struct type {
+				const value_type* p;
+				ZRDW_SIMD_INLINE value_type operator()(int64_t k) const { return p[k]; }
+				template <typename U> bool apart(const U* out, int64_t first, int64_t last) const {
+					if ((const void*)(p + first) == (const void*)out && sizeof(U) == sizeof(value_type)) return true;
+					return simd::disjoint(p + first, p + last, out, out + (last - first));
+				}
+				template <typename U> bool apart(const store_target<U>& t) const {
+					return simd::disjoint(p, p + t.n, t.p + t.lo, t.p + t.hi + 1);
+				}
+			};
+			static type make(const Node& n) { return type{ n.data() }; }
+		};
+
+		template <typename Node, int Mode>
+		struct kernel_of<Node, Mode, typename std::enable_if<is_storage<Node>::value && has_step<Node>::value>::type> { //strided view
+			using value_type = typename std::remove_cv<typename std::remove_pointer<decltype(std::declval<const Node&>().data())>::type>::type;
+			struct type {
+				const value_type* p;
+				int64_t stride;
+				ZRDW_SIMD_INLINE value_type operator()(int64_t k) const { return p[(Mode & unit_reads) ? k : k*stride]; }
+				template <typename U> bool apart(const U* out, int64_t first, int64_t last) const {
+					if ((const void*)(p + first*stride) == (const void*)out && sizeof(U) == sizeof(value_type) && stride == 1) return true;
+					return simd::disjoint(p + first*stride, p + (last - 1)*stride + 1, out, out + (last - first));
+				}
+				template <typename U> bool apart(const store_target<U>& t) const {
+					if ((const void*)p == (const void*)t.p && sizeof(U) == sizeof(value_type) && t.at == nullptr && stride == t.stride) return true;
+					return simd::disjoint(p, p + (t.n - 1)*stride + 1, t.p + t.lo, t.p + t.hi + 1);
+				}
+			};
+			static type make(const Node& n) { return type{ n.data(), n.step() }; }
+		};
+
+		template <typename Node, int Mode>
+		struct kernel_of<Node, Mode, typename std::enable_if<is_storage<Node>::value && has_index<Node>::value>::type> { //gather view, not prefetched: that would keep the loop scalar
+			using value_type = typename std::remove_cv<typename std::remove_pointer<decltype(std::declval<const Node&>().data())>::type>::type;
+			struct type {
+				const value_type* p;
+				const int64_t* at;
+				int64_t lo, hi;
+				bool ascending;
+				ZRDW_SIMD_INLINE value_type operator()(int64_t k) const { return p[at[k]]; }
+				template <typename U> bool apart(const U* out, int64_t first, int64_t last) const {
+					return hi < lo || simd::disjoint(p + lo, p + hi + 1, out, out + (last - first));
+				}
+				template <typename U> bool apart(const store_target<U>& t) const { //its own view when no elem repeats (v.mask(m) *= 2)
+					if ((const void*)p == (const void*)t.p && sizeof(U) == sizeof(value_type) && at == t.at && ascending) return true;
+					return hi < lo || simd::disjoint(p + lo, p + hi + 1, t.p + t.lo, t.p + t.hi + 1);
+				}
+			};
+			static type make(const Node& n) { return type{ n.data(), n.index(), n.lowest(), n.highest(), n.ascending() }; }
+		};
+
+		template <typename T, typename Expr, int Mode>
+		struct kernel_of<valarray<T, Expr>, Mode> : public kernel_of<Expr, Mode> {};
+
+		template <typename T, int Mode>
+		struct kernel_of<scalar<T>, Mode> {
+			struct type {
+				T k;
+				ZRDW_SIMD_INLINE T operator()(int64_t) const { return k; }
+				template <typename U> bool apart(const U*, int64_t, int64_t) const { return true; }
+				template <typename U> bool apart(const store_target<U>&) const { return true; }
+			};
+			static type make(const scalar<T>& s) { return type{ s.k }; }
+		};
+
+		//functor a kernel applies for Operation, the operation itself except where it would not vectorize
+		template <typename Operation, int Mode = 0, typename = void>
+		struct kernel_op {
+			using type = Operation;
+			static type make(const Operation& f) { return f; }
+		};
+
+		//textbook complex product: std's checks for inf/nan (C99 Annex G) keep the loop scalar, this one does not recover them
+		template <typename F, int Mode>
+		struct kernel_op<std::multiplies<std::complex<F>>, Mode> {
+			struct type {
+				ZRDW_SIMD_INLINE std::complex<F> operator()(const std::complex<F>& a, const std::complex<F>& b) const {
+					return std::complex<F>(a.real()*b.real() - a.imag()*b.imag(), a.real()*b.imag() + a.imag()*b.real());
+				}
+			};
+			static type make(const std::multiplies<std::complex<F>>&) { return type{}; }
+		};
+
+		template <typename Operation, typename Left, typename Right, int Mode>
+		struct kernel_of<Proxy<Operation, Left, Right>, Mode> {
+			using P = Proxy<Operation, Left, Right>;
+			using LK = kernel_of<typename std::decay<typename P::L>::type, Mode>;
+			using RK = kernel_of<typename std::decay<typename P::R>::type, Mode>;
+			using result_type = typename P::result_type;
+			struct type {
+				typename kernel_op<Operation, Mode>::type f;
+				typename LK::type l;
+				typename RK::type r;
+				ZRDW_SIMD_INLINE result_type operator()(int64_t k) const { return static_cast<result_type>(f(l(k), r(k))); }
+				template <typename U> bool apart(const U* out, int64_t first, int64_t last) const { return l.apart(out, first, last) && r.apart(out, first, last); }
+				template <typename U> bool apart(const store_target<U>& t) const { return l.apart(t) && r.apart(t); }
+			};
+			static type make(const P& p) { return type{ kernel_op<Operation, Mode>::make(p.f), LK::make(p.l), RK::make(p.r) }; }
+		};
+
+		template <typename Operation, typename Left, int Mode>
+		struct kernel_of<Proxy<Operation, Left, emptyOperand>, Mode> { //unary
+			using P = Proxy<Operation, Left, emptyOperand>;
+			using LK = kernel_of<typename std::decay<typename P::L>::type, Mode>;
+			using result_type = typename P::result_type;
+			struct type {
+				typename kernel_op<Operation, Mode>::type f;
+				typename LK::type l;
+				ZRDW_SIMD_INLINE result_type operator()(int64_t k) const { return static_cast<result_type>(f(l(k))); }
+				template <typename U> bool apart(const U* out, int64_t first, int64_t last) const { return l.apart(out, first, last); }
+				template <typename U> bool apart(const store_target<U>& t) const { return l.apart(t); }
+			};
+			static type make(const P& p) { return type{ kernel_op<Operation, Mode>::make(p.f), LK::make(p.l) }; }
+		};
+
+		template <typename T, typename K>
+		struct converting_kernel {
+			K k;
+			ZRDW_SIMD_INLINE T operator()(int64_t i) const { return static_cast<T>(k(i)); }
+			bool apart(const T* out, int64_t first, int64_t last) const { return k.apart(out, first, last); }
+			bool apart(const store_target<T>& t) const { return k.apart(t); }
+		};
+
+		template <typename T, typename Expr, int Mode = 0>
+		using kernel_for = converting_kernel<T, typename kernel_of<Expr, Mode>::type>;
+
+		template <typename T, int Mode = 0, typename T1, typename Expr1>
+		kernel_for<T, Expr1, Mode> make_kernel(const valarray<T1, Expr1>& e) {
+			return kernel_for<T, Expr1, Mode>{ kernel_of<Expr1, Mode>::make(e) };
+		}
+
+		/*
+		whether a node reads strided views (any), and whether all of them have stride 1 at runtime (unit):
+		v[slice(i, n, 1)] and span<T>(p, n) are strided views by type. the evaluation then runs in the unit_reads mode,
+		whose loads the compiler sees as contiguous and vectorizes as such, rather than on the strided one
+		*/
+		template <typename Node, typename = void>
+		struct unit_strides {
+			static constexpr bool any = false;
+			static bool unit(const Node&) { return true; }
+		};
+
+		template <typename Node>
+		struct unit_strides<Node, typename std::enable_if<is_storage<Node>::value && has_step<Node>::value>::type> {
+			static constexpr bool any = true;
+			static bool unit(const Node& n) { return n.step() == 1; }
+		};
+
+		template <typename T, typename Expr>
+		struct unit_strides<valarray<T, Expr>> : public unit_strides<Expr> {};
+
+		template <typename Operation, typename Left, typename Right>
+		struct unit_strides<Proxy<Operation, Left, Right>> {
+			using P = Proxy<Operation, Left, Right>;
+			using LS = unit_strides<typename std::decay<typename P::L>::type>;
+			using RS = unit_strides<typename std::decay<typename P::R>::type>;
+			static constexpr bool any = LS::any || RS::any;
+			static bool unit(const P& p) { return LS::unit(p.l) && RS::unit(p.r); }
+		};
+
+		template <typename Operation, typename Left>
+		struct unit_strides<Proxy<Operation, Left, emptyOperand>> {
+			using P = Proxy<Operation, Left, emptyOperand>;
+			using LS = unit_strides<typename std::decay<typename P::L>::type>;
+			static constexpr bool any = LS::any;
+			static bool unit(const P& p) { return LS::unit(p.l); }
+		};
+
+		/*
+		whether a node calls sin or cos on real arguments (any), and whether all of these are within
+		fastmath::huge_reduced over [first, last) (small), checked by one vectorized pass over the arguments:
+		the evaluation then runs in the small_trig mode, which skips the Payne-Hanek reduction for huge ones
+		*/
+		template <typename Node, typename = void>
+		struct trig_args {
+			static constexpr bool any = false;
+			static bool small(const Node&, int64_t, int64_t) { return true; }
+		};
+
+		template <typename T, typename Expr>
+		struct trig_args<valarray<T, Expr>> : public trig_args<Expr> {};
+
+		template <typename Operation, typename Left, typename Right>
+		struct trig_args<Proxy<Operation, Left, Right>> {
+			using P = Proxy<Operation, Left, Right>;
+			using LS = trig_args<typename std::decay<typename P::L>::type>;
+			using RS = trig_args<typename std::decay<typename P::R>::type>;
+			static constexpr bool any = LS::any || RS::any;
+			static bool small(const P& p, int64_t first, int64_t last) { return LS::small(p.l, first, last) && RS::small(p.r, first, last); }
+		};
+
+		template <typename Operation, typename Left>
+		struct trig_args<Proxy<Operation, Left, emptyOperand>> {
+			using P = Proxy<Operation, Left, emptyOperand>;
+			using LS = trig_args<typename std::decay<typename P::L>::type>;
+			static constexpr bool any = LS::any;
+			static bool small(const P& p, int64_t first, int64_t last) { return LS::small(p.l, first, last); }
+		};
+
+		//f(k), k the kernel of e in the mode its operands allow over [first, last); the modes e cannot use are not instantiated
+		template <typename T, typename T1, typename Expr1, typename F>
+		void with_kernel(const valarray<T1, Expr1>& e, int64_t first, int64_t last, F f) {
+			constexpr int unit = unit_strides<Expr1>::any ? unit_reads : 0, trig = trig_args<Expr1>::any ? small_trig : 0;
+			bool u = unit != 0 && unit_strides<Expr1>::unit(e);
+			bool s = trig != 0 && trig_args<Expr1>::small(e, first, last);
+			if (u && s) f(make_kernel<T, unit | trig>(e));
+			else if (u) f(make_kernel<T, unit>(e));
+			else if (s) f(make_kernel<T, trig>(e));
+			else f(make_kernel<T>(e));
+		}
+
+		/*
+		out[i - first] = k(i) for i in [first, last), the one evaluation loop behind materialization, assignment,
+		fill and chunked save: through the SIMD engine, and in chunks on the thread pool when the parallel mode
+		is on and the range is large enough. a k with an operand overlapping out (other than elem for elem, as in
+		a[slice(1, n, 1)] += a[slice(0, n, 1)]) would read elems already written: it is evaluated into a temporary first
+		*/
+		template <typename T, typename K>
+		void run_kernel(T* out, const K& k, int64_t first, int64_t last) {
+			int64_t n = last - first;
+			if (n > 0 && !k.apart(out, first, last)) {
+				vector<T> temp(n, uninitialized);
+				run_kernel(temp.data(), k, first, last);
+				run_kernel(out, typename kernel_of<vector<T>>::type{ temp.data() }, 0, n);
+				return;
+			}
+			thread_pool* pool = parallel::pool();
+			if (pool == nullptr || n < parallel::min_size()) {
+				simd::run(out, k, first, last);
+				return;
+			}
+			pool->parallel_for(n, parallel::grain_elems(sizeof(T)), [&](int64_t lo, int64_t hi) { simd::run(out + lo, k, first + lo, first + hi); });
+		}
+
+		//out[i - first] = T(e[i]) for i in [first, last)
+		template <typename T, typename T1, typename Expr1>
+		void evaluate(T* out, const valarray<T1, Expr1>& e, int64_t first, int64_t last) {
+			with_kernel<T>(e, first, last, [&](const auto& k) { run_kernel(out, k, first, last); });
+		}
+
+		//p[i*stride] = k(i) for i in [0, n), for strided targets, in index order: k must be apart from the target (see store)
+		template <typename T, typename K>
+		void run_kernel_strided(T* p, int64_t stride, const K& k, int64_t n) {
+			for (int64_t i = 0; i < n; i++) p[i*stride] = k(i);
+		}
+
+		//spacing of the elems of linear storage
+		template <typename N>
+		typename std::enable_if<has_step<N>::value, int64_t>::type step_of(const N& n) { return n.step(); }
+		template <typename N>
+		typename std::enable_if<!has_step<N>::value, int64_t>::type step_of(const N&) { return 1; }
+
+		//p[at[i]] = k(i) for i in [0, n), for gather views, in index order, prefetching the elems to be written: k must be apart from the target
+		template <typename T, typename K>
+		void run_kernel_scattered(T* p, const int64_t* at, const K& k, int64_t n) {
+			for (int64_t i = 0; i < n; i++) {
+				ZRDW_PREFETCH(p + at[i + index_span<T>::prefetch_distance], 1);
+				p[at[i]] = k(i);
+			}
+		}
+
+		//reduction ops, written as selects so that they vectorize to min/max instructions
+		template <typename T>
+		struct min_op {
+			ZRDW_SIMD_INLINE T operator()(const T& a, const T& b) const { return (b < a) ? b : a; }
+		};
+
+		template <typename T>
+		struct max_op {
+			ZRDW_SIMD_INLINE T operator()(const T& a, const T& b) const { return (a < b) ? b : a; }
+		};
+
+		static constexpr int64_t pairwise_block = 1024;
+
+		//sum of k over [first, last) by halves, down to blocks folded in lanes
+		template <typename T, typename K>
+		T pairwise_sum(const K& k, int64_t first, int64_t last) {
+			int64_t n = last - first;
+			if (n <= pairwise_block) return simd::fold<T>(k, first, last, std::plus<T>());
+			int64_t mid = first + (n / 2 + pairwise_block - 1) / pairwise_block * pairwise_block;
+			return pairwise_sum<T>(k, first, mid) + pairwise_sum<T>(k, mid, last);
+		}
+
+		template <typename T, typename K>
+		T sum_range(const K& k, int64_t first, int64_t last, summation how) {
+			if (first >= last) return T();
+			switch (how) {
+			case summation::kahan: return simd::kahan_sum<T>(k, first, last);
+			case summation::naive: return simd::fold<T>(k, first, last, std::plus<T>());
+			default: return pairwise_sum<T>(k, first, last);
+			}
+		}
+
+		//range(lo, hi) over [0, n), in chunks on the thread pool when the parallel mode is on; the partial results
+		//are joined pairwise in index order, so the result does not depend on which thread ran which chunk
+		template <typename T, typename Range, typename Op>
+		T reduce_chunks(int64_t n, Range range, Op op) {
+			thread_pool* pool = parallel::pool();
+			if (pool == nullptr || n < parallel::min_size()) return range(0, n);
+			int64_t grain = parallel::grain_elems(sizeof(T));
+			if (grain < pairwise_block) grain = pairwise_block;
+			int64_t chunks = (n + grain - 1) / grain;
+			std::vector<T> part(chunks);
+			pool->parallel_for(n, grain, [&](int64_t lo, int64_t hi) { part[lo / grain] = range(lo, hi); });
+			return simd::join(part.data(), chunks, op);
+		}
+
+		template <typename T, typename T1, typename Expr1>
+		T sum_of(const valarray<T1, Expr1>& v, summation how) {
+			const kernel_for<T, Expr1> k = make_kernel<T>(v);
+			return reduce_chunks<T>(static_cast<int64_t>(v.size()), [&](int64_t lo, int64_t hi) { return sum_range<T>(k, lo, hi, how); }, std::plus<T>());
+		}
+
+		template <typename T, typename T1, typename Expr1, typename Op>
+		T fold_of(const valarray<T1, Expr1>& v, Op op, const char* what) {
+			int64_t n = v.size();
+			if (n == 0) throw std::out_of_range(what);
+			const kernel_for<T, Expr1> k = make_kernel<T>(v);
+			return reduce_chunks<T>(n, [&](int64_t lo, int64_t hi) { return simd::fold<T>(k, lo, hi, op); }, op);
+		}
+
+		//|x|^2 of each elem, in the real type R
+		template <typename R, typename K>
+		struct norm_kernel {
+			K k;
+			template <typename X> static ZRDW_SIMD_INLINE R squared(const X& x) { return static_cast<R>(x)*static_cast<R>(x); }
+			template <typename X> static ZRDW_SIMD_INLINE R squared(const std::complex<X>& x) { return static_cast<R>(x.real())*x.real() + static_cast<R>(x.imag())*x.imag(); }
+			ZRDW_SIMD_INLINE R operator()(int64_t i) const { return squared(k(i)); }
+		};
+
+		template <typename T> struct real_of { using type = typename std::conditional<std::is_integral<T>::value, double, T>::type; };
+		template <typename T> struct real_of<std::complex<T>> { using type = T; };
+
+		//f(k(i)) as Acc
+		template <typename Acc, typename K, typename F>
+		struct map_kernel {
+			K k;
+			F f;
+			ZRDW_SIMD_INLINE Acc operator()(int64_t i) const { return static_cast<Acc>(f(k(i))); }
+		};
+
+		//(x(i) - mx)*(y(i) - my), x and y may be the same kernel
+		template <typename R, typename KX, typename KY>
+		struct deviation_kernel {
+			KX x;
+			KY y;
+			R mx, my;
+			ZRDW_SIMD_INLINE R operator()(int64_t i) const { return (static_cast<R>(x(i)) - mx)*(static_cast<R>(y(i)) - my); }
+		};
 	}
 
-	using namespace zw3425;
+	using namespace zrdw_hide;
 
 	//supported maths defined here: neg, add, sub, mul, div
 	template <typename T1>
@@ -338,6 +775,151 @@ namespace zrdw {
 		return maths_retType<OP::div, T1, T2>(l, r)();
 	}
 
+	//sum of a[i]*b[i] (no conjugate for complex), fused: a*b is never materialized
+	template <typename T1, typename Expr1, typename T2, typename Expr2>
+	auto dot(const valarray<T1, Expr1>& a, const valarray<T2, Expr2>& b, summation how = summation::pairwise) -> decltype((a*b).sum(how)) {
+		return (a*b).sum(how);
+	}
+
+	/*
+	reduce(init, reduce(f(e[0]), reduce(f(e[1]), ...))) in one streaming pass over the expression e, no temporaries:
+		double sq = transform_reduce(a - b, 0.0, std::plus<double>(), [](double d) { return d*d; });
+		int64_t positive = transform_reduce(a*b, int64_t(0), std::plus<int64_t>(), [](double x) { return int64_t(x > 0); });
+	f maps an elem to Acc, reduce joins two Acc in any order and grouping (associative and commutative),
+	so that it runs in SIMD lanes and, in the parallel mode, in chunks on the thread pool.
+	Acc must be default constructible; f and reduce may be lambdas
+	*/
+	template <typename T, typename Expr, typename Acc, typename Reduce, typename F>
+	Acc transform_reduce(const valarray<T, Expr>& e, Acc init, Reduce reduce, F f) {
+		int64_t n = e.size();
+		if (n == 0) return init;
+		const map_kernel<Acc, kernel_for<T, Expr>, F> k{ make_kernel<T>(e), f };
+		Acc acc = reduce_chunks<Acc>(n, [&](int64_t lo, int64_t hi) { return simd::fold<Acc>(k, lo, hi, reduce); }, reduce);
+		return reduce(init, acc);
+	}
+
+	template <typename T, typename Expr, typename Acc, typename Reduce>
+	Acc transform_reduce(const valarray<T, Expr>& e, Acc init, Reduce reduce) {
+		return transform_reduce(e, init, reduce, [](const T& x) { return static_cast<Acc>(x); });
+	}
+
+	/*
+	count, mean and sum of squared deviations (m2) of one series, or of two with their co-deviation (c2),
+	mergeable, so that they are computed piecewise and joined (Chan et al.):
+		moments<double> m = moments_of(a*b);  m.variance(), m.stddev(1)
+		comoments<double> c = comoments_of(x, y);  c.covariance(1), c.correlation()
+	*/
+	template <typename R>
+	struct moments {
+		int64_t count = 0;
+		R mean = R(), m2 = R();
+
+		// ddof 0 for the population variance, 1 for the sample variance
+		R variance(int ddof = 0) const { return m2 / static_cast<R>(count - ddof); }
+		R stddev(int ddof = 0) const { return std::sqrt(variance(ddof)); }
+
+		moments& operator+=(const moments& b) {
+			if (b.count == 0) return *this;
+			if (count == 0) return *this = b;
+			int64_t n = count + b.count;
+			R d = b.mean - mean;
+			mean += d*static_cast<R>(b.count) / static_cast<R>(n);
+			m2 += b.m2 + d*d*static_cast<R>(count)*static_cast<R>(b.count) / static_cast<R>(n);
+			count = n;
+			return *this;
+		}
+
+		friend moments operator+(moments a, const moments& b) { return a += b; }
+	};
+
+	template <typename R>
+	struct comoments {
+		int64_t count = 0;
+		R mean_x = R(), mean_y = R(), m2_x = R(), m2_y = R(), c2 = R();
+
+		R covariance(int ddof = 0) const { return c2 / static_cast<R>(count - ddof); }
+		R correlation(void) const { return c2 / std::sqrt(m2_x*m2_y); }
+
+		comoments& operator+=(const comoments& b) {
+			if (b.count == 0) return *this;
+			if (count == 0) return *this = b;
+			int64_t n = count + b.count;
+			R w = static_cast<R>(count)*static_cast<R>(b.count) / static_cast<R>(n);
+			R dx = b.mean_x - mean_x, dy = b.mean_y - mean_y;
+			mean_x += dx*static_cast<R>(b.count) / static_cast<R>(n);
+			mean_y += dy*static_cast<R>(b.count) / static_cast<R>(n);
+			m2_x += b.m2_x + dx*dx*w;
+			m2_y += b.m2_y + dy*dy*w;
+			c2 += b.c2 + dx*dy*w;
+			count = n;
+			return *this;
+		}
+
+		friend comoments operator+(comoments a, const comoments& b) { return a += b; }
+	};
+
+	namespace zrdw_hide {
+		//moments of [lo, hi): per block a sum, then the deviations from its mean while the block is still in cache
+		template <typename R, typename K>
+		moments<R> moments_range(const K& k, int64_t lo, int64_t hi) {
+			moments<R> m;
+			for (int64_t first = lo; first < hi; first += pairwise_block) {
+				int64_t last = (hi - first < pairwise_block) ? hi : first + pairwise_block;
+				moments<R> b;
+				b.count = last - first;
+				b.mean = simd::fold<R>(k, first, last, std::plus<R>()) / static_cast<R>(b.count);
+				b.m2 = simd::fold<R>(deviation_kernel<R, K, K>{ k, k, b.mean, b.mean }, first, last, std::plus<R>());
+				m += b;
+			}
+			return m;
+		}
+
+		template <typename R, typename KX, typename KY>
+		comoments<R> comoments_range(const KX& x, const KY& y, int64_t lo, int64_t hi) {
+			comoments<R> m;
+			for (int64_t first = lo; first < hi; first += pairwise_block) {
+				int64_t last = (hi - first < pairwise_block) ? hi : first + pairwise_block;
+				comoments<R> b;
+				b.count = last - first;
+				b.mean_x = simd::fold<R>(x, first, last, std::plus<R>()) / static_cast<R>(b.count);
+				b.mean_y = simd::fold<R>(y, first, last, std::plus<R>()) / static_cast<R>(b.count);
+				b.m2_x = simd::fold<R>(deviation_kernel<R, KX, KX>{ x, x, b.mean_x, b.mean_x }, first, last, std::plus<R>());
+				b.m2_y = simd::fold<R>(deviation_kernel<R, KY, KY>{ y, y, b.mean_y, b.mean_y }, first, last, std::plus<R>());
+				b.c2 = simd::fold<R>(deviation_kernel<R, KX, KY>{ x, y, b.mean_x, b.mean_y }, first, last, std::plus<R>());
+				m += b;
+			}
+			return m;
+		}
+	}
+
+	//one pass over memory, in double precision at least; not for complex
+	template <typename T, typename Expr, typename R = typename choose_type<T, double>::type>
+	moments<R> moments_of(const valarray<T, Expr>& x) {
+		static_assert(!is_complex<T>::value, "moments of complex valarray");
+		const kernel_for<R, Expr> k = make_kernel<R>(x);
+		return reduce_chunks<moments<R>>(static_cast<int64_t>(x.size()), [&](int64_t lo, int64_t hi) { return moments_range<R>(k, lo, hi); }, std::plus<moments<R>>());
+	}
+
+	//over the first min(x.size(), y.size()) elems
+	template <typename T1, typename Expr1, typename T2, typename Expr2, typename R = typename choose_type<typename choose_type<T1, T2>::type, double>::type>
+	comoments<R> comoments_of(const valarray<T1, Expr1>& x, const valarray<T2, Expr2>& y) {
+		static_assert(!is_complex<R>::value, "comoments of complex valarray");
+		int64_t n = (x.size() < y.size()) ? x.size() : y.size();
+		const kernel_for<R, Expr1> kx = make_kernel<R>(x);
+		const kernel_for<R, Expr2> ky = make_kernel<R>(y);
+		return reduce_chunks<comoments<R>>(n, [&](int64_t lo, int64_t hi) { return comoments_range<R>(kx, ky, lo, hi); }, std::plus<comoments<R>>());
+	}
+
+	template <typename T, typename Expr>
+	auto variance(const valarray<T, Expr>& x, int ddof = 0) -> decltype(moments_of(x).variance(ddof)) {
+		return moments_of(x).variance(ddof);
+	}
+
+	template <typename T1, typename Expr1, typename T2, typename Expr2>
+	auto covariance(const valarray<T1, Expr1>& x, const valarray<T2, Expr2>& y, int ddof = 0) -> decltype(comoments_of(x, y).covariance(ddof)) {
+		return comoments_of(x, y).covariance(ddof);
+	}
+
 	//ostream for valarray
 	template <typename T, typename Expr>
 	std::ostream& operator<<(std::ostream& os, const valarray<T, Expr>& v) {
@@ -353,17 +935,154 @@ namespace zrdw {
 		return os;
 	}
 
-	//Sqrt wraps std::sqrt, makes it a functor
+	namespace zrdw_hide {
+		//elementwise math on T gives T, int gives double
+		template <typename T> struct math_type { using type = T; };
+		template <> struct math_type<int> { using type = double; };
+
+		//backend of the functors below: the vectorizable approximations of FastMath.h, or libm with ZRDW_STRICT_MATH defined
+#ifdef ZRDW_STRICT_MATH
+		namespace math = std;
+#else
+		namespace math = fastmath;
+#endif
+	}
+
+	/*
+	functors of the lazy elementwise math, e.g. v.exp(), exp(a*t), pow(v, 0.5):
+	for float and double they inline into the SIMD kernels, see FastMath.h for the error bounds; complex goes to std
+	*/
+	//Sqrt, correctly rounded like std::sqrt, and vectorizable
 	template <typename T>
 	struct Sqrt {
 		static constexpr bool comp = is_complex<T>::value;
 		using result_type = typename ctype<comp, double>::type;
 		using argument_type = T;
-		result_type operator() (const T& x) const {
-			return std::sqrt(x);
+		ZRDW_SIMD_INLINE result_type operator() (const T& x) const {
+			return math::sqrt(static_cast<result_type>(x));
+		}
+	};
+
+	template <typename T>
+	struct Exp {
+		using result_type = typename math_type<T>::type;
+		using argument_type = T;
+		ZRDW_SIMD_INLINE result_type operator() (const T& x) const {
+			return math::exp(static_cast<result_type>(x));
+		}
+	};
+
+	template <typename T>
+	struct Log {
+		using result_type = typename math_type<T>::type;
+		using argument_type = T;
+		ZRDW_SIMD_INLINE result_type operator() (const T& x) const {
+			return math::log(static_cast<result_type>(x));
+		}
+	};
+
+	template <typename T>
+	struct Sin {
+		using result_type = typename math_type<T>::type;
+		using argument_type = T;
+		ZRDW_SIMD_INLINE result_type operator() (const T& x) const {
+			return math::sin(static_cast<result_type>(x));
+		}
+	};
+
+	template <typename T>
+	struct Cos {
+		using result_type = typename math_type<T>::type;
+		using argument_type = T;
+		ZRDW_SIMD_INLINE result_type operator() (const T& x) const {
+			return math::cos(static_cast<result_type>(x));
+		}
+	};
+
+	template <typename T>
+	struct Tanh {
+		using result_type = typename math_type<T>::type;
+		using argument_type = T;
+		ZRDW_SIMD_INLINE result_type operator() (const T& x) const {
+			return math::tanh(static_cast<result_type>(x));
+		}
+	};
+
+	template <typename T>
+	struct Erf {
+		static_assert(!is_complex<T>::value, "erf of complex valarray");
+		using result_type = typename math_type<T>::type;
+		using argument_type = T;
+		ZRDW_SIMD_INLINE result_type operator() (const T& x) const {
+			return math::erf(static_cast<result_type>(x));
+		}
+	};
+
+	//x^y, both converted to T first
+	template <typename T>
+	struct Pow {
+		using result_type = T;
+		ZRDW_SIMD_INLINE result_type operator() (const T& x, const T& y) const {
+			return math::pow(x, y);
+		}
+	};
+
+	//exact, |z| for complex
+	template <typename T>
+	struct Abs {
+		using result_type = typename std::conditional<is_complex<T>::value, typename real_of<T>::type, T>::type;
+		using argument_type = T;
+		ZRDW_SIMD_INLINE result_type operator() (const T& x) const {
+			return std::abs(x);
 		}
 	};
 
+#ifndef ZRDW_STRICT_MATH
+	namespace zrdw_hide {
+		//|x| as double, what trig_args bounds
+		struct magnitude {
+			template <typename X> ZRDW_SIMD_INLINE double operator()(const X& x) const { return static_cast<double>(std::abs(x)); }
+		};
+
+		//sin or cos of real arguments: small when the arguments are, and their largest magnitude over [first, last) is within reach of the short reduction
+		template <typename P>
+		struct trig_call {
+			using A = typename std::decay<typename P::L>::type;
+			using LS = trig_args<A>;
+			static constexpr bool any = !is_complex<typename P::T1>::value;
+			static bool small(const P& p, int64_t first, int64_t last) {
+				if (first >= last) return true;
+				if (!LS::small(p.l, first, last)) return false;
+				const map_kernel<double, typename kernel_of<A>::type, magnitude> k{ kernel_of<A>::make(p.l), magnitude() };
+				double m = reduce_chunks<double>(last - first, [&](int64_t lo, int64_t hi) { return simd::fold<double>(k, first + lo, first + hi, max_op<double>()); }, max_op<double>());
+				return m <= fastmath::huge_reduced;
+			}
+		};
+
+		template <typename T, typename Left>
+		struct trig_args<Proxy<Sin<T>, Left, emptyOperand>> : public trig_call<Proxy<Sin<T>, Left, emptyOperand>> {};
+
+		template <typename T, typename Left>
+		struct trig_args<Proxy<Cos<T>, Left, emptyOperand>> : public trig_call<Proxy<Cos<T>, Left, emptyOperand>> {};
+
+		template <typename T, int Mode>
+		struct kernel_op<Sin<T>, Mode, typename std::enable_if<(Mode & small_trig) != 0>::type> {
+			struct type {
+				ZRDW_SIMD_INLINE typename Sin<T>::result_type operator()(const T& x) const { return fastmath::sin_small(static_cast<typename Sin<T>::result_type>(x)); }
+			};
+			static type make(const Sin<T>&) { return type{}; }
+		};
+
+		template <typename T, int Mode>
+		struct kernel_op<Cos<T>, Mode, typename std::enable_if<(Mode & small_trig) != 0>::type> {
+			struct type {
+				ZRDW_SIMD_INLINE typename Cos<T>::result_type operator()(const T& x) const { return fastmath::cos_small(static_cast<typename Cos<T>::result_type>(x)); }
+			};
+			static type make(const Cos<T>&) { return type{}; }
+		};
+	}
+#endif
+
 	//valarray
 	// if Expr the valarray wraps is at the its first level,
 	// i.e. if Expr is vector<T>, then Expr does not need to be explicitly designated, else, Expr is explicitly designated as a kind of Proxy
@@ -375,16 +1094,19 @@ namespace zrdw {
 
 		valarray() : Expr() {}
 		explicit valarray(int64_t n) : Expr(n) {}
+		valarray(int64_t n, uninitialized_t) : Expr(n, uninitialized) {}
+		valarray(int64_t n, const T& value) : Expr(n, value) {}
 		valarray(std::initializer_list<T> lst) : Expr(lst) { /*cout << "list-init" << endl;*/ }
 		valarray(const valarray& val) : Expr(val) {}
+		valarray(valarray&& val) noexcept(std::is_nothrow_move_constructible<Expr>::value) : Expr(std::move(val)) {}
+
+		//wrap an existing storage, e.g. valarray<double, mapped_vector<double>> a(mapped_vector<double>("a.bin"))
+		explicit valarray(Expr&& storage) : Expr(std::move(storage)) {}
 
-		//ctor for vector from convertible valarray of vector or proxy
+		//ctor for vector from convertible valarray of vector or proxy, allocated once and evaluated straight into the buffer
 		template <typename T1, typename Expr1>
-		valarray(const valarray<T1, Expr1>& val) { //cout << "ctor from vector" << endl;
-			int64_t size = val.size();
-			for (int64_t i = 0; i<size; ++i) {
-				this->push_back(static_cast<T>(val[i]));
-			}
+		valarray(const valarray<T1, Expr1>& val) : Expr(static_cast<int64_t>(val.size()), uninitialized) { //cout << "ctor from vector" << endl;
+			evaluate(this->data(), val, 0, this->size());
 		}
 
 		//ctor for cases derived from Proxy
@@ -393,16 +1115,57 @@ namespace zrdw {
 
 		template <typename T1, typename Expr1>
 		valarray& assignment(const valarray<T1, Expr1>& v) {
-			uint64_t size = (this->size()<v.size()) ? this->size() : v.size();
-			for (uint64_t i = this->size(); i > size; --i) {
-				this->pop_back();
-			}
-			for (uint64_t i = 0; i<size; ++i) {
-				(*this)[i] = static_cast<T>(v[i]);
-			}
+			int64_t size = this->size();
+			if (static_cast<int64_t>(v.size()) < size) size = v.size();
+			this->resize(size);
+			with_kernel<T>(v, 0, size, [&](const auto& k) { store(k, size); });
 			return *this;
 		}
 
+		/*
+		k(0), ..., k(size - 1) over the elems: contiguous storage through run_kernel, strided and gather views by pointer, others through operator[].
+		a k that reads elems other than the one it writes (b = b.indirect(rev), a[slice(1, n, 1)] = a[slice(0, n, 1)])
+		is evaluated into a temporary first, as the right-hand side of std::valarray: by run_kernel, or store_copy for views
+		*/
+		template <typename K>
+		void store(const K& k, int64_t size) {
+			store(k, size, std::integral_constant<int, is_contiguous<Expr>::value ? 0 : (is_storage<Expr>::value && has_step<Expr>::value) ? 1
+				: (is_storage<Expr>::value && has_index<Expr>::value) ? 3 : 2>{});
+		}
+
+		template <typename K>
+		void store(const K& k, int64_t size, std::integral_constant<int, 0>) {
+			run_kernel(this->data(), k, 0, size);
+		}
+
+		template <typename K>
+		void store(const K& k, int64_t size, std::integral_constant<int, 1>) {
+			if (this->step() == 1) run_kernel(this->data(), k, 0, size); //a stride-1 span is contiguous: SIMD and parallel
+			else if (size > 0 && !k.apart(store_target<T>{ this->data(), this->step(), nullptr, 0, (size - 1)*this->step(), size })) store_copy(k, size);
+			else run_kernel_strided(this->data(), this->step(), k, size);
+		}
+
+		template <typename K>
+		void store(const K& k, int64_t size, std::integral_constant<int, 3>) {
+			if (size > 0 && !k.apart(store_target<T>{ this->data(), 1, this->index(), this->lowest(), this->highest(), size })) store_copy(k, size);
+			else run_kernel_scattered(this->data(), this->index(), k, size);
+		}
+
+		//k(0), ..., k(size - 1) into a temporary, then stored from it
+		template <typename K>
+		void store_copy(const K& k, int64_t size) {
+			vector<T> temp(size, uninitialized);
+			run_kernel(temp.data(), k, 0, size);
+			store(typename kernel_of<vector<T>>::type{ temp.data() }, size);
+		}
+
+		template <typename K>
+		void store(const K& k, int64_t size, std::integral_constant<int, 2>) {
+			for (int64_t i = 0; i<size; ++i) {
+				(*this)[i] = k(i);
+			}
+		}
+
 		valarray& operator=(const valarray& v) { //always take the smaller size
 			return assignment(v);
 		}
@@ -415,42 +1178,227 @@ namespace zrdw {
 
 		//change/init the value of each elem
 		valarray& operator=(const T t) {
-			int64_t size = this->size();
-			for (int64_t i = 0; i < size; ++i) {
-				(*this)[i] = static_cast<T>(t);
-			}
+			store(typename kernel_of<scalar<T>>::type{ t }, this->size());
 			return *this;
 		}
 
-		//accumulate using given function object
+		/*
+		compound assignment with a scalar or expression right-hand side, e.g. acc += x*w, in one fused pass:
+		the lazy acc + x*w is stored over acc, with no temporary, through the same path as operator=.
+		its kernel reads each elem of acc exactly where it is written; acc appearing again on the right
+		at the same index is fine too. at another offset (a[slice(1, n, 1)] += a[slice(0, n, 1)]) the right-hand side
+		is evaluated into a temporary first, so every elem is combined with the old value, as in std.
+		like operator=, the result takes the smaller size
+		*/
+		template <typename T1>
+		valarray& operator+=(const T1& r) {
+			return assignment(*this + r);
+		}
+
+		template <typename T1>
+		valarray& operator-=(const T1& r) {
+			return assignment(*this - r);
+		}
+
+		template <typename T1>
+		valarray& operator*=(const T1& r) {
+			return assignment(*this * r);
+		}
+
+		template <typename T1>
+		valarray& operator/=(const T1& r) {
+			return assignment(*this / r);
+		}
+
+		using Expr::operator[];
+
+		/*
+		lazy views of some of the elems, as std::slice_array, gslice_array, mask_array and indirect_array,
+		that take part in expressions and take assignments without copying:
+			v[slice(0, n/2, 2)] *= 2.0;                every other elem, in place
+			c = a[gslice(0, {r, k}, {ld, 1})] + b;     an r x k block of a matrix with leading dimension ld
+			v.mask(w) = 0.0;  y = v.indirect(idx)*x;
+		a slice is a strided span<T>, stored to with SIMD when its stride is 1; the others are an index_span<T>,
+		which gathers and scatters with prefetching. a right-hand side reading elems a strided or gather view
+		overwrites (b = b.indirect(rev)) is evaluated into a temporary first.
+		views select from contiguous or strided storage (not from gather views or Proxies), and must not outlive it.
+		as in std, on a const valarray they return copies
+		*/
+		template <typename E = Expr>
+		typename std::enable_if<is_linear<E>::value, valarray<T, span<T>>>::type operator[](const slice& s) {
+			if (s.size() > 0 && s.start() + (s.size() - 1)*s.stride() >= this->size()) throw std::out_of_range("slice out of range of valarray");
+			int64_t step = step_of(*this);
+			return valarray<T, span<T>>(span<T>((s.size() == 0) ? nullptr : this->data() + s.start()*step, s.size(), s.stride()*step));
+		}
+
+		template <typename E = Expr>
+		typename std::enable_if<is_linear<E>::value, valarray<T, index_span<T>>>::type operator[](const gslice& g) {
+			return valarray<T, index_span<T>>(index_span<T>(this->data(), offsets_of_gslice(g, this->size(), step_of(*this))));
+		}
+
+		//the elems where m[i] is true (nonzero), m of the same size: zrdw::vector<bool>, std::vector<bool>, a valarray, ...
+		template <typename M, typename E = Expr>
+		typename std::enable_if<is_linear<E>::value, valarray<T, index_span<T>>>::type mask(const M& m) {
+			return valarray<T, index_span<T>>(index_span<T>(this->data(), offsets_of_mask(m, this->size(), step_of(*this))));
+		}
+
+		//the elems at idx[0], idx[1], ..., any array of integers; indices may repeat
+		template <typename I, typename E = Expr>
+		typename std::enable_if<is_linear<E>::value, valarray<T, index_span<T>>>::type indirect(const I& idx) {
+			return valarray<T, index_span<T>>(index_span<T>(this->data(), offsets_of_indirect(idx, this->size(), step_of(*this))));
+		}
+
+		template <typename E = Expr>
+		typename std::enable_if<is_linear<E>::value, valarray<T>>::type operator[](const slice& s) const {
+			return valarray<T>(const_cast<valarray&>(*this)[s]);
+		}
+
+		template <typename E = Expr>
+		typename std::enable_if<is_linear<E>::value, valarray<T>>::type operator[](const gslice& g) const {
+			return valarray<T>(const_cast<valarray&>(*this)[g]);
+		}
+
+		template <typename M, typename E = Expr>
+		typename std::enable_if<is_linear<E>::value, valarray<T>>::type mask(const M& m) const {
+			return valarray<T>(const_cast<valarray&>(*this).mask(m));
+		}
+
+		template <typename I, typename E = Expr>
+		typename std::enable_if<is_linear<E>::value, valarray<T>>::type indirect(const I& idx) const {
+			return valarray<T>(const_cast<valarray&>(*this).indirect(idx));
+		}
+
+		//accumulate using given function object, a left fold in index order for any f
 		template <typename F, typename Type = typename F::result_type>
-		Type accumulate(F f) {
-			if (this->size() == 0) return T(); //no elem, return default zero-init value as return value
-			Type sum = static_cast<Type>((*this)[0]); //init to the first elem, for both + and * ...
+		Type accumulate(F f) const {
 			int64_t size = this->size();
+			if (size == 0) return T(); //no elem, return default zero-init value as return value
+			const kernel_for<T, Expr> k = make_kernel<T>(*this);
+			Type sum = static_cast<Type>(k(0)); //init to the first elem, for both + and * ...
 			for (int64_t i = 1; i<size; ++i) {
-				sum = f(sum, (*this)[i]);
+				sum = f(sum, k(i));
 			}
 			return sum;
 		}
 
-		//sum up elements
-		T sum() {
-			return accumulate(std::plus<T>());
+		/*
+		reductions, straight over the expression: (a*b).sum() never materializes a*b.
+		they fold in several SIMD accumulators and, in the parallel mode, in chunks on the thread pool
+		*/
+		T sum(summation how = summation::pairwise) const {
+			return sum_of<T>(*this, how);
+		}
+
+		//smallest elem, the first of several equal ones; not for complex, and nan elems give an unspecified result
+		T min() const {
+			return fold_of<T>(*this, min_op<T>(), "min of an empty valarray");
+		}
+
+		T max() const {
+			return fold_of<T>(*this, max_op<T>(), "max of an empty valarray");
+		}
+
+		//in double precision at least: the mean of valarray<int> or <float> is a double
+		typename choose_type<T, double>::type mean(summation how = summation::pairwise) const {
+			using M = typename choose_type<T, double>::type;
+			int64_t size = this->size();
+			if (size == 0) throw std::out_of_range("mean of an empty valarray");
+			return sum_of<M>(*this, how) / static_cast<typename real_of<M>::type>(size);
+		}
+
+		//euclidean norm, sqrt of the sum of |x|^2, as double for valarray<int>
+		typename real_of<T>::type norm2(summation how = summation::pairwise) const {
+			using R = typename real_of<T>::type;
+			const norm_kernel<R, kernel_for<T, Expr>> k{ make_kernel<T>(*this) };
+			R sum = reduce_chunks<R>(static_cast<int64_t>(this->size()), [&](int64_t lo, int64_t hi) { return sum_range<R>(k, lo, hi, how); }, std::plus<R>());
+			return std::sqrt(sum);
 		}
 
-		//apply a unary function to valarray elements
-		template <typename Func, typename Type = typename Func::result_type>
-		valarray<Type, Proxy<Func, valarray<T, Expr>>> apply(Func f) {
+		//apply a unary function to valarray elements, lazily; f may be a lambda, the elems then have the type it returns
+		template <typename Func, typename Type = typename op_result<Func, T, emptyOperand>::type>
+		valarray<Type, Proxy<Func, valarray<T, Expr>>> apply(Func f) const {
 			return valarray<Type, Proxy<Func, valarray<T, Expr>>>(f, *this, emptyOperand());
 		}
 
 		//calc square root of each element
 		template <typename Type = typename Sqrt<T>::result_type>
-		valarray<Type, Proxy<Sqrt<T>, valarray<T, Expr>>> sqrt() {
+		valarray<Type, Proxy<Sqrt<T>, valarray<T, Expr>>> sqrt() const {
 			return apply(Sqrt<T>());
 		}
+
+		//lazy elementwise math, see Exp, Log, ... for the element types
+		valarray<typename Exp<T>::result_type, Proxy<Exp<T>, valarray<T, Expr>>> exp() const {
+			return apply(Exp<T>());
+		}
+
+		valarray<typename Log<T>::result_type, Proxy<Log<T>, valarray<T, Expr>>> log() const {
+			return apply(Log<T>());
+		}
+
+		valarray<typename Sin<T>::result_type, Proxy<Sin<T>, valarray<T, Expr>>> sin() const {
+			return apply(Sin<T>());
+		}
+
+		valarray<typename Cos<T>::result_type, Proxy<Cos<T>, valarray<T, Expr>>> cos() const {
+			return apply(Cos<T>());
+		}
+
+		valarray<typename Tanh<T>::result_type, Proxy<Tanh<T>, valarray<T, Expr>>> tanh() const {
+			return apply(Tanh<T>());
+		}
+
+		template <typename U = T> //deferred, Erf<complex> does not compile
+		valarray<typename Erf<U>::result_type, Proxy<Erf<U>, valarray<T, Expr>>> erf() const {
+			return apply(Erf<U>());
+		}
+
+		valarray<typename Abs<T>::result_type, Proxy<Abs<T>, valarray<T, Expr>>> abs() const {
+			return apply(Abs<T>());
+		}
 	};
+
+	//free forms of the lazy elementwise math, exp(-r*t) for (-r*t).exp()
+	template <typename T, typename Expr>
+	auto exp(const valarray<T, Expr>& v) -> decltype(v.exp()) { return v.exp(); }
+
+	template <typename T, typename Expr>
+	auto log(const valarray<T, Expr>& v) -> decltype(v.log()) { return v.log(); }
+
+	template <typename T, typename Expr>
+	auto sin(const valarray<T, Expr>& v) -> decltype(v.sin()) { return v.sin(); }
+
+	template <typename T, typename Expr>
+	auto cos(const valarray<T, Expr>& v) -> decltype(v.cos()) { return v.cos(); }
+
+	template <typename T, typename Expr>
+	auto tanh(const valarray<T, Expr>& v) -> decltype(v.tanh()) { return v.tanh(); }
+
+	template <typename T, typename Expr>
+	auto erf(const valarray<T, Expr>& v) -> decltype(v.erf()) { return v.erf(); }
+
+	template <typename T, typename Expr>
+	auto abs(const valarray<T, Expr>& v) -> decltype(v.abs()) { return v.abs(); }
+
+	template <typename T, typename Expr>
+	auto sqrt(const valarray<T, Expr>& v) -> decltype(v.sqrt()) { return v.sqrt(); }
+
+	//elementwise x^y, of two valarrays or of a valarray and a scalar, in the joint type (double for int)
+	template <typename T1, typename Expr1, typename T2, typename Expr2, typename R = typename math_type<typename choose_type<T1, T2>::type>::type>
+	valarray<R, Proxy<Pow<R>, valarray<T1, Expr1>, valarray<T2, Expr2>>> pow(const valarray<T1, Expr1>& x, const valarray<T2, Expr2>& y) {
+		return valarray<R, Proxy<Pow<R>, valarray<T1, Expr1>, valarray<T2, Expr2>>>(Pow<R>(), x, y);
+	}
+
+	template <typename T1, typename Expr1, typename K, typename R = typename math_type<typename choose_type<T1, K>::type>::type>
+	typename enable_if<!is_valarray<K>::value && is_valarray<K>::do_maths, valarray<R, Proxy<Pow<R>, valarray<T1, Expr1>, scalar<K>>>>::type
+	pow(const valarray<T1, Expr1>& x, const K& y) {
+		return valarray<R, Proxy<Pow<R>, valarray<T1, Expr1>, scalar<K>>>(Pow<R>(), x, scalar<K>(y));
+	}
+
+	template <typename K, typename T2, typename Expr2, typename R = typename math_type<typename choose_type<K, T2>::type>::type>
+	typename enable_if<!is_valarray<K>::value && is_valarray<K>::do_maths, valarray<R, Proxy<Pow<R>, scalar<K>, valarray<T2, Expr2>>>>::type
+	pow(const K& x, const valarray<T2, Expr2>& y) {
+		return valarray<R, Proxy<Pow<R>, scalar<K>, valarray<T2, Expr2>>>(Pow<R>(), scalar<K>(x), y);
+	}
 };
 #endif /* _Valarray_h */
 
@@ -2,8 +2,14 @@
 #define _VECTOR_H_
 
 #include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
+#include "Allocator.h"
+#include "VectorStats.h"
 
 namespace zrdw {
 
@@ -75,10 +81,182 @@ namespace zrdw {
 		}
 	};
 
+	/*
+	relocation layer, every grow/copy path of vector goes through it.
+	trivially copyable types (all the types valarray allows) are copied with a single memcpy
+	and never destructed one by one, the others fall back to per-elem placement-new
+	*/
+	template <typename T, bool = std::is_trivially_copyable<T>::value>
+	struct relocator {
+		// move n elems from src into raw storage at dst, then destruct the src elems
+		static void relocate(T* dst, T* src, int64_t n) {
+			construct_from(dst, src, n);
+			destroy(src, n);
+		}
+
+		/*
+		move-construct n elems from src into raw storage at dst, src stays to be destructed by the caller.
+		elems whose move ctor may throw are copied when they can be, so that src is intact if a ctor throws;
+		the dst elems built so far are then destructed before rethrowing
+		*/
+		static void construct_from(T* dst, T* src, int64_t n) {
+			int64_t i = 0;
+			try {
+				for (; i < n; i++) {
+					new (dst + i) T(std::move_if_noexcept(src[i]));
+				}
+			}
+			catch (...) {
+				destroy(dst, i);
+				throw;
+			}
+		}
+
+		// copy-construct n elems read from src into raw storage at dst, if a ctor throws the dst elems built so far are destructed
+		// T(*src) rather than T{ *src }, so that ranges of other arithmetic types convert
+		template <typename Iter>
+		static void copy(T* dst, Iter src, int64_t n) {
+			int64_t i = 0;
+			try {
+				for (; i < n; ++i, ++src) {
+					new (dst + i) T(*src);
+				}
+			}
+			catch (...) {
+				destroy(dst, i);
+				throw;
+			}
+		}
+
+		static void destroy(T* p, int64_t n) {
+			for (int64_t i = 0; i < n; i++) {
+				p[i].~T();
+			}
+		}
+
+		/*
+		move n elems to an overlapping position inside the same buffer. a move ctor that throws here leaves
+		destroyed slots among the elems, which nothing can repair without another ctor that may throw:
+		vector requires a nothrow move ctor of T for the operations that shift (see vector)
+		*/
+		static void shift(T* dst, T* src, int64_t n) {
+			if (dst < src) {
+				for (int64_t i = 0; i < n; i++) {
+					new (dst + i) T(std::move(src[i]));
+					src[i].~T();
+				}
+			}
+			else if (dst > src) {
+				for (int64_t i = n - 1; i >= 0; i--) {
+					new (dst + i) T(std::move(src[i]));
+					src[i].~T();
+				}
+			}
+		}
+	};
+
 	template <typename T>
+	struct relocator<T, true> {
+		static void relocate(T* dst, T* src, int64_t n) {
+			if (n > 0) std::memcpy(dst, src, n*sizeof(T));
+		}
+
+		static void construct_from(T* dst, T* src, int64_t n) {
+			if (n > 0) std::memcpy(dst, src, n*sizeof(T));
+		}
+
+		template <typename Iter>
+		static void copy(T* dst, Iter src, int64_t n) {
+			using src_type = typename std::remove_cv<typename std::remove_pointer<Iter>::type>::type;
+			copy(dst, src, n, std::integral_constant<bool, std::is_pointer<Iter>::value && std::is_same<src_type, T>::value>{});
+		}
+
+		template <typename Iter>
+		static void copy(T* dst, Iter src, int64_t n, std::true_type) { // contiguous T, one memcpy
+			if (n > 0) std::memcpy(dst, src, n*sizeof(T));
+		}
+
+		template <typename Iter>
+		static void copy(T* dst, Iter src, int64_t n, std::false_type) {
+			for (int64_t i = 0; i < n; ++i, ++src) {
+				new (dst + i) T(*src);
+			}
+		}
+
+		static void destroy(T*, int64_t) {}
+
+		static void shift(T* dst, T* src, int64_t n) {
+			if (n > 0) std::memmove(dst, src, n*sizeof(T));
+		}
+	};
+
+	//tag for constructors that allocate without initializing the elems
+	struct uninitialized_t {};
+	constexpr uninitialized_t uninitialized{};
+
+	/*
+	checking policies for element access and iterators:
+	check_full keeps range checks and the invalid_iterator severity diagnostics,
+	check_light only does range checks, check_none uses raw pointers as iterators and checks nothing
+	*/
+	struct check_full {
+		static constexpr bool bounds = true;
+		static constexpr bool versions = true;
+	};
+
+	struct check_light {
+		static constexpr bool bounds = true;
+		static constexpr bool versions = false;
+	};
+
+	struct check_none {
+		static constexpr bool bounds = false;
+		static constexpr bool versions = false;
+	};
+
+	//policy vector uses when none is given, -DZRDW_UNCHECKED selects check_none for release builds,
+	//whose iterators are then raw pointers that std algorithms treat as contiguous (memmove, vectorized loops)
+#ifdef ZRDW_UNCHECKED
+	using check_default = check_none;
+#else
+	using check_default = check_full;
+#endif
+
+	/*
+	growth policies decide the new buffer length once a push runs out of slack at one end,
+	grow() gets the current length, the minimal length needed and sizeof(T)
+	*/
+	struct grow_double {
+		static int64_t grow(int64_t len, int64_t, size_t) { return 2 * len; }
+	};
+
+	struct grow_golden { // 1.5x, lets the allocator reuse the blocks freed by earlier growth
+		static int64_t grow(int64_t len, int64_t, size_t) { return len + len / 2; }
+	};
+
+	template <size_t PageSize = 4096>
+	struct grow_page { // doubles, then rounds the buffer up to whole pages
+		static int64_t grow(int64_t len, int64_t needed, size_t elem_size) {
+			int64_t n = (2 * len < needed) ? needed : 2 * len;
+			uint64_t bytes = (n * elem_size + PageSize - 1) / PageSize * PageSize;
+			return static_cast<int64_t>(bytes / elem_size);
+		}
+	};
+
+	/*
+	exceptions: reallocations keep the vector as it was if a ctor throws (see grow_with), but insert, erase and
+	a push that recenters the elems instead of reallocating move them inside their buffer (relocator::shift),
+	and require T's move ctor not to throw: a throw there leaves destroyed elems among the live ones.
+	trivially copyable T (all the types valarray allows) move with memmove and are always safe
+	*/
+	template <typename T, typename Check = check_default, typename Alloc = heap_allocator<T>, typename Growth = grow_double>
 	class vector {
-		const int64_t size_init = 8;
+		static constexpr int64_t size_init = 8; // first buffer length, unless Alloc holds inline storage
 	private:
+		// elems per alignment boundary, 1 when T does not evenly divide the alignment
+		static constexpr int64_t align_stride = (alloc_alignment<Alloc>::value % sizeof(T) == 0) ? alloc_alignment<Alloc>::value / sizeof(T) : 1;
+
+		Alloc alloc;
 		T* head;
 		T* front; //points to the first elem in the vector
 		int64_t cap_front, cap_rear;
@@ -86,8 +264,29 @@ namespace zrdw {
 		int64_t modify_version = 0;
 		int64_t realloc_reassign_version = 0;
 
+		using stats = vector_stats_hooks<vector>; // no-ops unless ZRDW_VECTOR_STATS
+
+		// every buffer comes from allocate() and goes back through release_buffer(), so that both are counted,
+		// each side only for non-empty buffers
+		T* allocate(int64_t n) {
+			T* p = alloc.allocate(n);
+			if (n > 0) stats::allocated(n*sizeof(T));
+			return p;
+		}
+
+		void release_buffer(void) {
+			if (len_Vector > 0) stats::released(len_Vector*sizeof(T), cap_front*sizeof(T), cap_rear*sizeof(T));
+			alloc.deallocate(head, len_Vector);
+		}
+
+		// give back a new buffer that was never taken into use
+		void free_buffer(T* p, int64_t n) {
+			if (n > 0) stats::released(n*sizeof(T), 0, 0);
+			alloc.deallocate(p, n);
+		}
+
 		void copy(const vector& v) {
-			head = (T*) ::operator new(v.len_Vector*sizeof(T));
+			head = (v.len_Vector > 0) ? allocate(v.len_Vector) : nullptr;
 
 			this->cap_front = v.cap_front;
 			this->cap_rear = v.cap_rear;
@@ -95,16 +294,12 @@ namespace zrdw {
 			this->len_elem = v.len_elem;
 
 			front = head + this->cap_front;
-			for (int64_t i = 0; i < len_elem; ++i) {
-				new (front + i) T{ v.front[i] };
-			}
+			relocator<T>::copy(front, (const T*) v.front, len_elem);
 		}
 
 		void destroy(void) {
-			for (int64_t i = 0; i < len_elem; i++) { // destruct each elem in vector
-				front[i].~T();
-			}
-			::operator delete(head);
+			relocator<T>::destroy(front, len_elem); // destruct each elem in vector
+			release_buffer();
 			head = front = nullptr; //?
 			cap_front = cap_rear = len_Vector = len_elem = 0;
 
@@ -113,37 +308,396 @@ namespace zrdw {
 			// ++realloc_reassign_version;
 		}
 
-	public:
-		vector(void) {
-			head = (T*) ::operator new(size_init*sizeof(T));
-			front = head;
+		// destruct the elems from position n on, their room becomes rear slack
+		void truncate(int64_t n) {
+			relocator<T>::destroy(front + n, len_elem - n);
+			cap_rear += len_elem - n;
+			len_elem = n;
+
+			modified();
+		}
+
+		// copy-construct value up to size n, room must have been reserved
+		void fill_rear(int64_t n, const T& value) {
+			for (int64_t i = len_elem; i < n; i++) {
+				new (front + i) T(value);
+			}
+			cap_rear -= n - len_elem;
+			len_elem = n;
+
+			modified();
+		}
+
+		// version bookkeeping for iterator invalidation, compiled out unless Check::versions
+		void modified(void) {
+			if (Check::versions) ++modify_version;
+		}
+
+		void reallocated(void) {
+			if (Check::versions) {
+				++modify_version;
+				++realloc_reassign_version;
+			}
+		}
+
+		// round a front slack up so that front lands on an alignment boundary, no-op unless Alloc over-aligns
+		static int64_t aligned_slack(int64_t cap) {
+			return (cap + align_stride - 1) / align_stride * align_stride;
+		}
+
+		// shift the elems in place so that new_cap_front slack is left before them
+		void move_front(int64_t new_cap_front) {
+			relocator<T>::shift(head + new_cap_front, front, len_elem);
+			stats::shifted(len_elem*sizeof(T));
+			cap_rear += cap_front - new_cap_front;
+			cap_front = new_cap_front;
+			front = head + new_cap_front;
+
+			reallocated();
+		}
+
+		/*
+		recentering: when a push runs out of slack at one end while at least half of the buffer is free
+		at the other end, the elems are shifted in place to split that slack instead of reallocating.
+		a push_back/pop_front FIFO therefore settles on a fixed buffer
+		*/
+		int64_t recentered_front_for_rear(void) const {
+			if (cap_front == 0 || cap_front < len_Vector / 2) return cap_front;
+			return cap_front / 2 / align_stride * align_stride;
+		}
+
+		int64_t recentered_front_for_front(void) const {
+			if (cap_rear == 0 || cap_rear < len_Vector / 2) return 0;
+			return (cap_rear - cap_rear / 2) / align_stride * align_stride;
+		}
+
+		// buffer length for at least needed elems (slack included), as the growth policy says
+		int64_t grown_length(int64_t needed) const {
+			int64_t n = (len_Vector == 0) ? first_length() : Growth::grow(len_Vector, needed, sizeof(T));
+			return (n < needed) ? needed : n;
+		}
+
+		static int64_t first_length(void) {
+			return (inline_storage<Alloc>::capacity > 0) ? static_cast<int64_t>(inline_storage<Alloc>::capacity) : size_init;
+		}
+
+		// empty vector over a fresh buffer of exactly n elems, all rear slack
+		void allocate_exact(int64_t n) {
+			if (n < 0) throw std::out_of_range("In explicit constructor n<0");
+			head = front = (n > 0) ? allocate(n) : nullptr;
 			cap_front = 0;
-			cap_rear = size_init;
-			len_Vector = size_init;
+			cap_rear = n;
+			len_Vector = n;
 			len_elem = 0;
 
 			modify_version = realloc_reassign_version = 0;
 		}
 
-		explicit vector(int64_t n) {
-			if (n <= 0) throw std::out_of_range("In explicit constructor n<=0");
+		/*
+		make room for n raw elems at position pos, and count them in size(): the caller must construct them,
+		or give the room back with drop_gap if a ctor throws.
+		shifts whichever side has both the slack and the fewer elems, reallocates at most once otherwise
+		*/
+		T* open_gap(int64_t pos, int64_t n) {
+			if (pos < 0 || pos > len_elem) throw std::out_of_range("Index out of range in insert");
+			if (n == 0) return front + pos;
+			bool front_fits = cap_front >= n, rear_fits = cap_rear >= n;
+			if (front_fits && (!rear_fits || pos < len_elem - pos)) { // move [0, pos) down
+				relocator<T>::shift(front - n, front, pos);
+				stats::shifted(pos*sizeof(T));
+				front -= n;
+				cap_front -= n;
+				reallocated();
+			}
+			else if (rear_fits) { // move [pos, len_elem) up
+				relocator<T>::shift(front + pos + n, front + pos, len_elem - pos);
+				cap_rear -= n;
+				if (pos < len_elem) {
+					stats::shifted((len_elem - pos)*sizeof(T));
+					reallocated();
+				}
+				else modified();
+			}
+			else if (remaps) {
+				int64_t new_cap_front = aligned_slack(cap_front);
+				resize_buffer(new_cap_front, grown_length(cap_front + len_elem + n) + new_cap_front - cap_front);
+				relocator<T>::shift(front + pos + n, front + pos, len_elem - pos);
+				cap_rear -= n;
+			}
 			else {
-				head = (T*) ::operator new(n*sizeof(T));
-				front = head;
-				for (int64_t i = 0; i < n; i++) {
-					new (front + i) T{};
+				int64_t new_cap_front = aligned_slack(cap_front);
+				int64_t new_len = grown_length(cap_front + len_elem + n) + new_cap_front - cap_front;
+				T* new_head = allocate(new_len);
+				T* new_front = new_head + new_cap_front;
+				int64_t done = 0; // elems of [0, pos) already in the new buffer
+				try {
+					relocator<T>::construct_from(new_front, front, pos);
+					done = pos;
+					relocator<T>::construct_from(new_front + pos + n, front + pos, len_elem - pos);
+				}
+				catch (...) { // the vector is left as it was
+					relocator<T>::destroy(new_front, done);
+					free_buffer(new_head, new_len);
+					throw;
 				}
-				cap_front = 0;
-				cap_rear = 0;
-				len_Vector = n;
-				len_elem = n;
+				relocator<T>::destroy(front, len_elem);
+				if (len_Vector > 0) stats::reallocated(len_elem*sizeof(T));
+				release_buffer();
+
+				head = new_head;
+				front = new_front;
+				cap_front = new_cap_front;
+				cap_rear = new_len - new_cap_front - len_elem - n;
+				len_Vector = new_len;
+				reallocated();
+			}
+			len_elem += n;
+			return front + pos;
+		}
 
-				modify_version = realloc_reassign_version = 0;
+		// undo open_gap(pos, n) whose n raw elems were never constructed: the elems after them move back down
+		void drop_gap(int64_t pos, int64_t n) {
+			relocator<T>::shift(front + pos, front + pos + n, len_elem - pos - n);
+			cap_rear += n;
+			len_elem -= n;
+
+			modified();
+		}
+
+		// construct the n elems of the gap at pos by build(gap), which destructs what it built if it throws;
+		// the gap is then dropped, and the vector holds its old elems
+		template <typename Build>
+		void fill_gap(int64_t pos, int64_t n, Build build) {
+			T* gap = open_gap(pos, n);
+			try {
+				build(gap);
+			}
+			catch (...) {
+				drop_gap(pos, n);
+				throw;
+			}
+		}
+
+		// destruct [first, last) and close the gap by shifting the side with fewer elems
+		void close_gap(int64_t first, int64_t last) {
+			if (first < 0 || last > len_elem || first > last) throw std::out_of_range("Index out of range in erase");
+			int64_t n = last - first;
+			if (n == 0) return;
+			relocator<T>::destroy(front + first, n);
+			if (first < len_elem - last) { // move [0, first) up
+				relocator<T>::shift(front + n, front, first);
+				stats::shifted(first*sizeof(T));
+				front += n;
+				cap_front += n;
+			}
+			else { // move [last, len_elem) down
+				relocator<T>::shift(front + first, front + last, len_elem - last);
+				stats::shifted((len_elem - last)*sizeof(T));
+				cap_rear += n;
+			}
+			len_elem -= n;
+
+			modified();
+		}
+
+		template <typename Iter>
+		void insert_range(int64_t pos, Iter first, Iter last, std::forward_iterator_tag) {
+			int64_t n = std::distance(first, last);
+			fill_gap(pos, n, [&](T* gap) { relocator<T>::copy(gap, first, n); });
+		}
+
+		template <typename Iter>
+		void insert_range(int64_t pos, Iter first, Iter last, std::input_iterator_tag) { // length unknown, gather first
+			if (pos == len_elem) {
+				int64_t old_len = len_elem;
+				try {
+					for (; first != last; ++first) push_back(T(*first));
+				}
+				catch (...) {
+					truncate(old_len);
+					throw;
+				}
+				return;
+			}
+			vector temp(alloc);
+			for (; first != last; ++first) temp.push_back(T(*first));
+			fill_gap(pos, temp.len_elem, [&](T* gap) { relocator<T>::construct_from(gap, temp.front, temp.len_elem); });
+		}
+
+		// take over v's buffer, or move its elems out when the buffer is inline storage of v's allocator
+		void steal(vector& v) {
+			if (inline_storage<Alloc>::holds(v.alloc, v.head)) {
+				this->head = allocate(v.len_Vector);
+				this->front = head + v.cap_front;
+				relocator<T>::relocate(front, v.front, v.len_elem);
+				v.release_buffer();
+			}
+			else {
+				this->head = v.head;
+				this->front = v.front;
 			}
+			this->cap_front = v.cap_front;
+			this->cap_rear = v.cap_rear;
+			this->len_elem = v.len_elem;
+			this->len_Vector = v.len_Vector;
+
+			v.head = v.front = nullptr;
+			v.cap_front = v.cap_rear = v.len_elem = v.len_Vector = 0;
+		}
+
+		// whether Alloc can grow a buffer in place (mremap), usable when elems may be moved bytewise
+		static constexpr bool remaps = std::is_trivially_copyable<T>::value && alloc_remaps<Alloc>::value;
+
+		// switch to a buffer of new_len with new_cap_front slack before the elems
+		void resize_buffer(int64_t new_cap_front, int64_t new_len) {
+			if (remaps) {
+				regrow(new_cap_front, new_len);
+				return;
+			}
+			T* new_head = allocate(new_len);
+			try {
+				relocate_to(new_head, new_cap_front, new_len);
+			}
+			catch (...) {
+				free_buffer(new_head, new_len);
+				throw;
+			}
+		}
+
+		/*
+		reallocate to new_len with new_cap_front slack, constructing the new elem at index at of the new buffer
+		before the others move over, as args may refer to one of them.
+		if a ctor throws the vector is left as it was, unless T's move may throw and T cannot be copied
+		*/
+		template <class... Args>
+		void grow_with(int64_t new_cap_front, int64_t new_len, int64_t at, Args&&... args) {
+			T* new_head = allocate(new_len);
+			try {
+				new (new_head + at) T(std::forward<Args>(args)...);
+			}
+			catch (...) {
+				free_buffer(new_head, new_len);
+				throw;
+			}
+			try {
+				relocate_to(new_head, new_cap_front, new_len);
+			}
+			catch (...) {
+				new_head[at].~T();
+				free_buffer(new_head, new_len);
+				throw;
+			}
+		}
+
+		/*
+		resize the buffer through Alloc::reallocate, which keeps its bytes, then shift the elems into place,
+		so that a failed reallocate leaves the vector as it was. elems the new length would cut off
+		are shifted first instead, and shifted back if it fails (a memmove: remaps implies trivially copyable)
+		*/
+		void regrow(int64_t new_cap_front, int64_t new_len) {
+			bool cut = cap_front + len_elem > new_len;
+			if (cut) relocator<T>::shift(head + new_cap_front, front, len_elem);
+			T* new_head;
+			try {
+				new_head = alloc_remaps<Alloc>::reallocate(alloc, head, len_Vector, new_len);
+			}
+			catch (...) {
+				if (cut) relocator<T>::shift(front, head + new_cap_front, len_elem);
+				throw;
+			}
+			if (!cut) relocator<T>::shift(new_head + new_cap_front, new_head + cap_front, len_elem);
+			if (len_Vector > 0) {
+				stats::released(len_Vector*sizeof(T), cap_front*sizeof(T), cap_rear*sizeof(T));
+				// the kept bytes when Alloc copied them to a new buffer rather than remapping, plus the shift
+				int64_t copied = alloc_remaps<Alloc>::copies(alloc, len_Vector, new_len) ? ((len_Vector < new_len) ? len_Vector : new_len)*sizeof(T) : 0;
+				stats::reallocated(copied + ((new_cap_front != cap_front) ? len_elem*sizeof(T) : 0));
+			}
+			if (new_len > 0) stats::allocated(new_len*sizeof(T));
+
+			head = new_head;
+			front = new_head + new_cap_front;
+			cap_front = new_cap_front;
+			cap_rear = new_len - new_cap_front - len_elem;
+			len_Vector = new_len;
+
+			reallocated();
+		}
+
+		// make rear slack for one push without constructing a second buffer: recenter, or regrow when Alloc remaps
+		void room_in_place_rear(void) {
+			if (recentered_front_for_rear() < cap_front) {
+				move_front(recentered_front_for_rear());
+				return;
+			}
+			int64_t new_cap_front = aligned_slack(cap_front);
+			regrow(new_cap_front, grown_length(len_Vector + 1) + new_cap_front - cap_front);
+		}
+
+		void room_in_place_front(void) {
+			if (recentered_front_for_front() > 0) {
+				move_front(recentered_front_for_front());
+				return;
+			}
+			int64_t grown = grown_length(len_Vector + 1) - len_Vector;
+			int64_t new_cap_front = aligned_slack(grown - 1) + 1; // front is aligned once e is in
+			regrow(new_cap_front, new_cap_front + len_elem + cap_rear);
+		}
+
+		// move elems into new_head leaving new_cap_front slack before them, then release the old buffer
+		void relocate_to(T* new_head, int64_t new_cap_front, int64_t new_len) {
+			T* new_front = new_head + new_cap_front;
+			relocator<T>::relocate(new_front, front, len_elem);
+			if (len_Vector > 0) stats::reallocated(len_elem*sizeof(T)); // a first buffer is no reallocation
+			release_buffer();
+
+			head = new_head;
+			front = new_front;
+			cap_front = new_cap_front;
+			cap_rear = new_len - new_cap_front - len_elem;
+			len_Vector = new_len;
+
+			reallocated();
+		}
+
+	public:
+		vector(void) : vector(Alloc()) {}
+
+		// storage comes from a, e.g. arena_allocator<T>(some_arena)
+		// nothing is allocated until the first push
+		explicit vector(const Alloc& a) : alloc(a) {
+			head = front = nullptr;
+			cap_front = cap_rear = 0;
+			len_Vector = len_elem = 0;
+
+			modify_version = realloc_reassign_version = 0;
+		}
+
+		explicit vector(int64_t n) {
+			allocate_exact(n);
+			for (int64_t i = 0; i < n; i++) {
+				new (front + i) T{};
+			}
+			cap_rear = 0;
+			len_elem = n;
+		}
+
+		// only allocates, the n elems hold whatever was in memory until written,
+		// for storage that is about to be overwritten by an expression or a read
+		vector(int64_t n, uninitialized_t, const Alloc& a = Alloc()) : alloc(a) {
+			static_assert(std::is_trivially_copyable<T>::value, "uninitialized vector needs a trivially copyable T");
+			allocate_exact(n);
+			cap_rear = 0;
+			len_elem = n;
+		}
+
+		// n copies of value, written in a single pass
+		vector(int64_t n, const T& value, const Alloc& a = Alloc()) : alloc(a) {
+			allocate_exact(n);
+			fill_rear(n, value);
 		}
 
 		// copy ctor
-		vector(const vector& v) {
+		vector(const vector& v) : alloc(v.alloc) {
 			copy(v);
 
 			this->modify_version = this->realloc_reassign_version = 0;
@@ -155,51 +709,35 @@ namespace zrdw {
 				destroy();
 				copy(v);
 
-				++(this->modify_version);
-				++(this->realloc_reassign_version);
+				this->reallocated();
 			}
 			return *this;
 		}
 
+		// moves only hand the buffer over, except out of inline storage, which needs a heap buffer
+		static constexpr bool nothrow_move = inline_storage<Alloc>::capacity == 0;
+
 		// move ctor
-		vector(vector&& v) {
-			this->head = v.head;
-			this->front = v.front;
-			this->cap_front = v.cap_front;
-			this->cap_rear = v.cap_rear;
-			this->len_elem = v.len_elem;
-			this->len_Vector = v.len_Vector;
+		vector(vector&& v) noexcept(nothrow_move) : alloc(v.alloc) {
+			steal(v);
 
 			this->modify_version = this->realloc_reassign_version = 0;
 
-			v.head = v.front = nullptr;
-			v.cap_front = v.cap_rear = v.len_elem = v.len_Vector = 0;
-
 			// the moved-from vector being invalidated
-			++v.modify_version;
-			++v.realloc_reassign_version;
+			v.reallocated();
 		}
 
 		//move assign
-		vector& operator=(vector&& v) {
+		vector& operator=(vector&& v) noexcept(nothrow_move) {
 			if (this != &v) {
 				destroy();
-				this->head = v.head;
-				this->front = v.front;
-				this->cap_front = v.cap_front;
-				this->cap_rear = v.cap_rear;
-				this->len_elem = v.len_elem;
-				this->len_Vector = v.len_Vector;
-
-				++(this->modify_version);
-				++(this->realloc_reassign_version);
+				this->alloc = v.alloc; // the buffer taken over must go back to where it came from
+				steal(v);
 
-				v.head = v.front = nullptr;
-				v.cap_front = v.cap_rear = v.len_elem = v.len_Vector = 0;
+				this->reallocated();
 
 				// the moved-from vector being invalidated
-				++v.modify_version;
-				++v.realloc_reassign_version;
+				v.reallocated();
 			}
 			return *this;
 		}
@@ -207,192 +745,151 @@ namespace zrdw {
 		~vector(void) {
 			destroy();
 
-			++modify_version;
-			++realloc_reassign_version;
+			reallocated();
 		}
 
 		int64_t size(void) const {
 			return len_elem;
 		}
 
-		T& operator[](int64_t k) {
-			if (k >= len_elem || k<0) throw std::out_of_range("Index out of range in vector[]");
-			return *(front + k);
-			//return front[k];
+		Alloc get_allocator(void) const {
+			return alloc;
 		}
 
-		const T& operator[](int64_t k) const {
-			if (k >= len_elem || k<0) throw std::out_of_range("Index out of range in vector[]");
-			return *(front + k);
-			//return front[k];
+		// alignment of the buffer, and of front whenever the vector reallocates
+		static constexpr size_t alignment = alloc_alignment<Alloc>::value;
+
+		// whether front is on an alignment boundary, pop_front/push_front move it off
+		bool is_aligned(void) const {
+			return (uintptr_t)front % alignment == 0;
 		}
 
-		void push_back(const T& e) {
-			if (cap_rear < 0) throw std::out_of_range("cap_rear<0 in push_back");
-			if (cap_rear == 0) { // realloc
-				T* old_head = head;
-				T* old_front = front;
-				T* temp_head = (T*) ::operator new(2 * len_Vector*sizeof(T));
-				T* temp_front = temp_head + cap_front;
+		// shift the elems down in place so that front is aligned again, no reallocation
+		void realign(void) {
+			if (is_aligned() || align_stride == 1) return;
+			move_front(cap_front / align_stride * align_stride);
+		}
 
+		// number of elems the vector can hold before push_back reallocates
+		int64_t capacity(void) const {
+			return len_elem + cap_rear;
+		}
 
-				head = temp_head;
-				front = temp_front;
-				new (front + len_elem) T{ e };
+		// number of elems the vector can hold before push_front reallocates
+		int64_t capacity_front(void) const {
+			return cap_front + len_elem;
+		}
 
-				for (int64_t i = 0; i < len_elem; i++) {
-					new (temp_front + i) T{ std::move(old_front[i]) }; //std::move, xvalue
-				}
+		// make room for n elems at the rear, front slack is kept
+		void reserve(int64_t n) {
+			if (n < 0) throw std::out_of_range("n<0 in reserve");
+			if (n <= len_elem + cap_rear) return;
+			int64_t new_cap_front = aligned_slack(cap_front);
+			int64_t new_len = new_cap_front + n;
+			resize_buffer(new_cap_front, new_len);
+		}
 
-				cap_rear = len_Vector;
-				len_Vector *= 2;
+		// make room for n elems at the front, rear slack is kept
+		void reserve_front(int64_t n) {
+			if (n < 0) throw std::out_of_range("n<0 in reserve_front");
+			if (n <= cap_front + len_elem) return;
+			int64_t new_cap_front = aligned_slack(n - len_elem);
+			int64_t new_len = new_cap_front + len_elem + cap_rear;
+			resize_buffer(new_cap_front, new_len);
+		}
 
-				for (int64_t i = 0; i < len_elem; i++) {
-					old_front[i].~T();
-				}
-				::operator delete(old_head);
-				old_head = old_front = nullptr;
+		// shrinking is O(1) for trivially destructible T, growing value-initializes the new elems
+		void resize(int64_t n) {
+			if (n < 0) throw std::out_of_range("n<0 in resize");
+			if (n <= len_elem) {
+				truncate(n);
+				return;
+			}
+			reserve(n);
+			for (int64_t i = len_elem; i < n; i++) {
+				new (front + i) T{};
+			}
+			cap_rear -= n - len_elem;
+			len_elem = n;
 
-				len_elem++;
-				cap_rear--;
+			modified();
+		}
 
-				++modify_version;
-				++realloc_reassign_version;
+		void resize(int64_t n, const T& value) {
+			if (n < 0) throw std::out_of_range("n<0 in resize");
+			if (n <= len_elem) {
+				truncate(n);
+				return;
+			}
+			if (n > len_elem + cap_rear) {
+				T temp(value); // value may refer to an elem
+				reserve(n);
+				fill_rear(n, temp);
 			}
 			else {
-				new (front + len_elem) T{ e };
-				len_elem++;
-				cap_rear--;
-
-				++modify_version;
+				fill_rear(n, value);
 			}
 		}
 
-		void push_back(T&& e) {
-			if (cap_rear < 0) throw std::out_of_range("cap_rear<0 in push_back");
-			if (cap_rear == 0) {
-				T* old_head = head;
-				T* old_front = front;
-				T* temp_head = (T*) ::operator new(2 * len_Vector*sizeof(T));
-				T* temp_front = temp_head + cap_front;
+		// drop all slack at both ends
+		void shrink_to_fit(void) {
+			if (cap_front == 0 && cap_rear == 0) return;
+			if (len_elem == 0) { // back to the empty state, with no buffer
+				destroy();
+				reallocated();
+				return;
+			}
+			resize_buffer(0, len_elem);
+		}
 
+		// range checked unless Check is check_none
+		T& operator[](int64_t k) {
+			if (Check::bounds && (k >= len_elem || k<0)) throw std::out_of_range("Index out of range in vector[]");
+			return *(front + k);
+			//return front[k];
+		}
 
-				head = temp_head;
-				front = temp_front;
-				new (front + len_elem) T{ std::move(e) };
+		const T& operator[](int64_t k) const {
+			if (Check::bounds && (k >= len_elem || k<0)) throw std::out_of_range("Index out of range in vector[]");
+			return *(front + k);
+			//return front[k];
+		}
 
-				for (int64_t i = 0; i < len_elem; i++) {
-					new (temp_front + i) T{ std::move(old_front[i]) }; //std::move, xvalue
-				}
+		// the elems are contiguous from data() to data() + size(), under any Check policy,
+		// e.g. std::sort(v.data(), v.data() + v.size()) runs at raw-pointer speed on a checked vector
+		T* data(void) {
+			return front;
+		}
 
-				cap_rear = len_Vector;
-				len_Vector *= 2;
+		const T* data(void) const {
+			return front;
+		}
 
-				for (int64_t i = 0; i < len_elem; i++) {
-					old_front[i].~T();
-				}
-				::operator delete(old_head);
-				old_head = old_front = nullptr;
+		// always range checked
+		T& at(int64_t k) {
+			if (k >= len_elem || k<0) throw std::out_of_range("Index out of range in vector::at");
+			return front[k];
+		}
 
-				len_elem++;
-				cap_rear--;
+		const T& at(int64_t k) const {
+			if (k >= len_elem || k<0) throw std::out_of_range("Index out of range in vector::at");
+			return front[k];
+		}
 
-				++modify_version;
-				++realloc_reassign_version;
-			}
-			else {
-				new (front + len_elem) T{ std::move(e) };
-				len_elem++;
-				cap_rear--;
+		void push_back(const T& e) {
+			emplace_back(e);
+		}
 
-				++modify_version;
-			}
+		void push_back(T&& e) {
+			emplace_back(std::move(e));
 		}
 
 		void push_front(const T& e) {
-			if (cap_front < 0) throw std::out_of_range("cap_front<0 in push_front");
-			if (cap_front == 0) {
-				//if (head != front) std::cout << "INTERESTING..." << std::endl;
-				T* old_head = head;
-				T* old_front = front;
-				T* temp_head = (T*) ::operator new(2 * len_Vector*sizeof(T));
-				T* temp_front = temp_head + len_Vector;
-
-				head = temp_head;
-				front = temp_front;
-				front--;
-				new (front) T{ e };
-
-				for (int64_t i = 0; i < len_elem; i++) {
-					new (temp_front + i) T{ std::move(old_front[i]) }; //std::move, xvalue
-				}
-
-				cap_front = len_Vector;
-				len_Vector *= 2;
-
-				for (int64_t i = 0; i < len_elem; i++) {
-					old_front[i].~T();
-				}
-				::operator delete(old_head);
-				old_head = old_front = nullptr;
-
-				cap_front--;
-				len_elem++;
-
-				++modify_version;
-				++realloc_reassign_version;
-			}
-			else {
-				front--;
-				new (front) T{ e };
-				cap_front--;
-				len_elem++;
-
-				++modify_version;
-			}
+			emplace_front(e);
 		}
 
 		void push_front(T&& e) {
-			if (cap_front < 0) throw std::out_of_range("cap_front<0 in push_front");
-			if (cap_front == 0) {
-				//if (head != front) std::cout << "INTERESTING..." << std::endl;
-				T* old_head = head;
-				T* old_front = front;
-				T* temp_head = (T*) ::operator new(2 * len_Vector*sizeof(T));
-				T* temp_front = temp_head + len_Vector;
-
-				head = temp_head;
-				front = temp_front;
-				front--;
-				new (front) T{ std::move(e) };
-
-				for (int64_t i = 0; i < len_elem; i++) {
-					new (temp_front + i) T{ std::move(old_front[i]) }; //std::move, xvalue
-				}
-
-				cap_front = len_Vector;
-				len_Vector *= 2;
-
-				for (int64_t i = 0; i < len_elem; i++) {
-					old_front[i].~T();
-				}
-				::operator delete(old_head);
-				old_head = old_front = nullptr;
-
-				cap_front--;
-				len_elem++;
-
-				++modify_version;
-				++realloc_reassign_version;
-			}
-			else {
-				front--;
-				new (front) T{ std::move(e) };
-				cap_front--;
-				len_elem++;
-
-				++modify_version;
-			}
+			emplace_front(std::move(e));
 		}
 
 		void pop_back(void) {
@@ -401,7 +898,7 @@ namespace zrdw {
 			len_elem--;
 			cap_rear++;
 
-			++modify_version;
+			modified();
 		}
 
 		void pop_front(void) {
@@ -411,84 +908,164 @@ namespace zrdw {
 			len_elem--;
 			cap_front++;
 
-			++modify_version;
+			modified();
 		}
 
-		// variadic class template function
+		// construct an elem in place from args, forwarded as given: rvalues are never copied and T may be move-only
 		template <class... Args>
 		void emplace_back(Args&&... args) {
-			if (cap_rear < 0) throw std::out_of_range("cap_rear<0 in push_back");
-			if (cap_rear == 0) {
-				T* old_head = head;
-				T* old_front = front;
-				T* temp_head = (T*) ::operator new(2 * len_Vector*sizeof(T));
-				T* temp_front = temp_head + cap_front;
+			if (cap_rear < 0) throw std::out_of_range("cap_rear<0 in emplace_back");
+			if (cap_rear == 0 && (remaps || recentered_front_for_rear() < cap_front)) { // room without a second buffer
+				T temp(std::forward<Args>(args)...); // args may refer to an elem, which is about to move
+				room_in_place_rear();
+				new (front + len_elem) T(std::move(temp));
+			}
+			else if (cap_rear == 0) { // realloc
+				int64_t new_cap_front = aligned_slack(cap_front);
+				int64_t new_len = grown_length(len_Vector + 1) + new_cap_front - cap_front;
+				grow_with(new_cap_front, new_len, new_cap_front + len_elem, std::forward<Args>(args)...);
+			}
+			else {
+				new (front + len_elem) T(std::forward<Args>(args)...);
+				modified();
+			}
+			len_elem++;
+			cap_rear--;
+		}
 
+		template <class... Args>
+		void emplace_front(Args&&... args) {
+			if (cap_front < 0) throw std::out_of_range("cap_front<0 in emplace_front");
+			if (cap_front == 0 && (remaps || recentered_front_for_front() > 0)) { // room without a second buffer
+				T temp(std::forward<Args>(args)...); // args may refer to an elem, which is about to move
+				room_in_place_front();
+				new (front - 1) T(std::move(temp));
+			}
+			else if (cap_front == 0) { // realloc, the new slack goes to the front
+				int64_t grown = grown_length(len_Vector + 1) - len_Vector;
+				int64_t new_cap_front = aligned_slack(grown - 1) + 1; // front is aligned once the elem is in
+				int64_t new_len = new_cap_front + len_elem + cap_rear;
+				grow_with(new_cap_front, new_len, new_cap_front - 1, std::forward<Args>(args)...);
+			}
+			else {
+				new (front - 1) T(std::forward<Args>(args)...);
+				modified();
+			}
+			front--;
+			cap_front--;
+			len_elem++;
+		}
 
-				head = temp_head;
-				front = temp_front;
-				new (front + len_elem) T{ args... };
+		// construct an elem at position pos, the side with fewer elems is shifted
+		template <class... Args>
+		void emplace(int64_t pos, Args&&... args) {
+			if (pos == len_elem) {
+				emplace_back(std::forward<Args>(args)...);
+				return;
+			}
+			if (pos == 0) {
+				emplace_front(std::forward<Args>(args)...);
+				return;
+			}
+			T temp(std::forward<Args>(args)...); // args may refer to an elem, which open_gap may move
+			fill_gap(pos, 1, [&](T* gap) { new (gap) T(std::move(temp)); });
+		}
 
-				for (int64_t i = 0; i < len_elem; i++) {
-					new (temp_front + i) T{ std::move(old_front[i]) }; //std::move, xvalue
-				}
+		/*
+		bulk insertion and erase, positions are indices as for operator[].
+		each computes the final size first, reallocates at most once and moves elems in bulk.
+		ranges must not come from this vector.
+		if an elem ctor throws, insert and emplace leave the vector with its old elems, unless T's move may throw
+		*/
+		template <typename Iter, typename = typename std::iterator_traits<Iter>::iterator_category>
+		void append(Iter first, Iter last) {
+			insert(len_elem, first, last);
+		}
 
-				cap_rear = len_Vector;
-				len_Vector *= 2;
+		template <typename Iter, typename = typename std::iterator_traits<Iter>::iterator_category>
+		void insert(int64_t pos, Iter first, Iter last) {
+			insert_range(pos, first, last, typename std::iterator_traits<Iter>::iterator_category{});
+		}
 
-				for (int64_t i = 0; i < len_elem; i++) {
-					old_front[i].~T();
+		void insert(int64_t pos, int64_t n, const T& value) {
+			if (n < 0) throw std::out_of_range("n<0 in insert");
+			T temp(value); // value may refer to an elem
+			fill_gap(pos, n, [&](T* gap) {
+				int64_t i = 0;
+				try {
+					for (; i < n; i++) {
+						new (gap + i) T(temp);
+					}
+				}
+				catch (...) {
+					relocator<T>::destroy(gap, i);
+					throw;
 				}
-				::operator delete(old_head);
-				old_head = old_front = nullptr;
+			});
+		}
 
-				len_elem++;
-				cap_rear--;
+		void insert(int64_t pos, const T& value) {
+			insert(pos, 1, value);
+		}
 
-				++modify_version;
-				++realloc_reassign_version;
-			}
-			else {
-				new (front + len_elem) T{ args... };
-				len_elem++;
-				cap_rear--;
+		void insert(int64_t pos, T&& value) {
+			emplace(pos, std::move(value));
+		}
 
-				++modify_version;
-			}
+		void erase(int64_t first, int64_t last) {
+			close_gap(first, last);
+		}
+
+		void erase(int64_t pos) {
+			close_gap(pos, pos + 1);
+		}
+
+		void clear(void) {
+			truncate(0);
+		}
+
+		template <typename Iter, typename = typename std::iterator_traits<Iter>::iterator_category>
+		void assign(Iter first, Iter last) {
+			truncate(0);
+			insert(0, first, last);
+		}
+
+		void assign(int64_t n, const T& value) {
+			if (n < 0) throw std::out_of_range("n<0 in assign");
+			T temp(value); // value may refer to an elem
+			truncate(0);
+			if (n > len_Vector - cap_front) reserve(n);
+			fill_rear(n, temp);
+		}
+
+		void assign(std::initializer_list<T> lst) {
+			assign(lst.begin(), lst.end());
 		}
 
 		// member template ctor's member template function
 		template <typename Iter>
 		void vector_iter(Iter b, Iter e, std::random_access_iterator_tag x) {
-			//std::cout << "random access tag" << std::endl;
 			cap_front = cap_rear = 0;
 			len_Vector = len_elem = e - b;
 
-			head = (T*) ::operator new(len_Vector*sizeof(T));
+			head = (len_Vector > 0) ? allocate(len_Vector) : nullptr; // an empty range allocates nothing, as the default ctor
 			front = head;
-			for (int64_t i = 0; b != e; ++b) {
-				new (front + i) T{ *b };
-				++i;
-			}
+			relocator<T>::copy(front, b, len_elem);
 		}
 
 		template <typename Iter>
 		void vector_iter(Iter b, Iter e, std::input_iterator_tag x) {
-			//std::cout << "input tag" << std::endl;
-			cap_front = 0;
-			cap_rear = size_init;
-			len_Vector = size_init;
-			len_elem = 0;
+			head = front = nullptr;
+			cap_front = cap_rear = 0;
+			len_Vector = len_elem = 0;
 
-			head = (T*) ::operator new(size_init*sizeof(T));
-			front = head;
 			for (; b != e; ++b) {
 				push_back(*b);
 			}
 		}
 
-		// member template ctor
-		template <typename Iter>
+		// member template ctor, only for iterators so that vector(n, value) is not taken for a range
+		template <typename Iter, typename = typename std::iterator_traits<Iter>::iterator_category>
 		vector(Iter b, Iter e) {
 			typename std::iterator_traits<Iter>::iterator_category x{};
 
@@ -499,31 +1076,26 @@ namespace zrdw {
 
 		//initializer_list constructor
 		vector(std::initializer_list<T> lst) {
-			//std::cout << "list init..." << std::endl;
 			cap_front = cap_rear = 0;
 			len_Vector = len_elem = lst.size();
 
 			modify_version = realloc_reassign_version = 0;
 
-			head = (T*) ::operator new(len_Vector*sizeof(T));
+			head = (len_Vector > 0) ? allocate(len_Vector) : nullptr;
 			front = head;
-			int64_t i = 0;
-			for (T elem : lst) {
-				new (front + i) T{ elem };
-				++i;
-			}
+			relocator<T>::copy(front, lst.begin(), len_elem);
 		}
 
-		//declare iterator, defined later
-		class iterator;
+		//declare checked_iterator, defined later
+		class checked_iterator;
 
-		//const_iterator defined here
-		class const_iterator {
-			friend iterator;
+		//checked_const_iterator defined here
+		class checked_const_iterator {
+			friend checked_iterator;
 		private:
 			T* head; // iter.head = vec->head
 			int64_t position; // 0-indexed
-			const vector<T>* vec;
+			const vector* vec;
 			int64_t vec_modify_version, vec_realloc_reassign_version;
 
 		public:
@@ -533,15 +1105,15 @@ namespace zrdw {
 			using pointer = T*;
 			using reference = T&;
 
-			const_iterator(void) {
+			checked_const_iterator(void) {
 				head = nullptr;
 				position = 0;
 				vec = nullptr;
 				vec_modify_version = vec_realloc_reassign_version = 0;
 			}
 
-			// const vector<T>* v or vector<T>& v
-			const_iterator(const vector<T>& v, int64_t pos) {
+			// const vector* v or vector& v
+			checked_const_iterator(const vector& v, int64_t pos) {
 				head = v.head;
 				position = pos;
 				vec = &v;
@@ -552,17 +1124,15 @@ namespace zrdw {
 				//validate();
 			}
 
-			const_iterator(const const_iterator& iter) {
-				iter.validate();
-				this->head = iter.head;
+			checked_const_iterator(const checked_const_iterator& iter) {
+				this->head = iter.head; // copying is not a use, validated when dereferenced or moved
 				this->position = iter.position;
 				this->vec = iter.vec;
 				this->vec_modify_version = iter.vec_modify_version;
 				this->vec_realloc_reassign_version = iter.vec_realloc_reassign_version;
 			}
 
-			const_iterator(const iterator& iter) {
-				iter.validate();
+			checked_const_iterator(const checked_iterator& iter) {
 				this->head = iter.head;
 				this->position = iter.position;
 				this->vec = iter.vec;
@@ -570,8 +1140,7 @@ namespace zrdw {
 				this->vec_realloc_reassign_version = iter.vec_realloc_reassign_version;
 			}
 
-			const_iterator& operator=(const const_iterator& iter) {
-				iter.validate();
+			checked_const_iterator& operator=(const checked_const_iterator& iter) {
 				this->head = iter.head;
 				this->position = iter.position;
 				this->vec = iter.vec;
@@ -580,8 +1149,7 @@ namespace zrdw {
 				return *this;
 			}
 
-			const_iterator& operator=(const iterator& iter) {
-				iter.validate();
+			checked_const_iterator& operator=(const checked_iterator& iter) {
 				this->head = iter.head;
 				this->position = iter.position;
 				this->vec = iter.vec;
@@ -590,102 +1158,102 @@ namespace zrdw {
 				return *this;
 			}
 
-			bool operator==(const const_iterator& iter) const {
+			bool operator==(const checked_const_iterator& iter) const {
 				validate();
 				iter.validate();
 				if (this->vec != iter.vec) throw std::runtime_error("Comparing two different iters.");
 				return this->position == iter.position;
 			}
 
-			bool operator==(const iterator& iter) const {
+			bool operator==(const checked_iterator& iter) const {
 				validate();
 				iter.validate();
 				if (this->vec != iter.vec) throw std::runtime_error("Comparing two different iters.");
 				return this->position == iter.position;
 			}
 
-			bool operator<(const const_iterator& iter) const {
+			bool operator<(const checked_const_iterator& iter) const {
 				validate();
 				iter.validate();
 				if (this->vec != iter.vec) throw std::runtime_error("Comparing two different iters.");
 				return this->position < iter.position;
 			}
 
-			bool operator<(const iterator& iter) const {
+			bool operator<(const checked_iterator& iter) const {
 				validate();
 				iter.validate();
 				if (this->vec != iter.vec) throw std::runtime_error("Comparing two different iters.");
 				return this->position < iter.position;
 			}
 
-			const_iterator operator+(int64_t k) const {
+			checked_const_iterator operator+(int64_t k) const {
 				validate();
-				const_iterator temp(*this);
+				checked_const_iterator temp(*this);
 				temp.position += k;
 				//temp.validate();
 				return temp;
 			}
 
-			const_iterator operator-(int64_t k) const {
+			checked_const_iterator operator-(int64_t k) const {
 				validate();
-				const_iterator temp(*this);
+				checked_const_iterator temp(*this);
 				temp.position -= k;
 				//temp.validate();
 				return temp;
 			}
 
-			ptrdiff_t operator-(const const_iterator& iter) const {
+			ptrdiff_t operator-(const checked_const_iterator& iter) const {
 				if (this->vec != iter.vec) throw std::runtime_error("Two different iters.");
 				validate();
 				iter.validate();
 				return this->position - iter.position;
 			}
 
-			ptrdiff_t operator-(const iterator& iter) const {
+			ptrdiff_t operator-(const checked_iterator& iter) const {
 				if (this->vec != iter.vec) throw std::runtime_error("Two different iters.");
 				validate();
 				iter.validate();
 				return this->position - iter.position;
 			}
 
-			const_iterator& operator++(void) { //prefix	
+			checked_const_iterator& operator++(void) { //prefix	
 				validate();
 				++position;
 				//validate();
 				return *this;
 			}
 
-			const_iterator operator++(int) { // postfix
+			checked_const_iterator operator++(int) { // postfix
 				validate();
-				const_iterator temp(*this);
+				checked_const_iterator temp(*this);
 				++(*this);
 				// validate();
 				return temp;
 			}
 
-			const_iterator& operator--(void) { //prefix
+			checked_const_iterator& operator--(void) { //prefix
 				validate();
 				--position;
 				//validate();
 				return *this;
 			}
 
-			const_iterator operator--(int) { //postfix
+			checked_const_iterator operator--(int) { //postfix
 				validate();
-				const_iterator temp(*this);
+				checked_const_iterator temp(*this);
 				--(*this);
 				// validate();
 				return temp;
 			}
 
-			const_iterator& operator+=(int64_t k) {
+			checked_const_iterator& operator+=(int64_t k) {
 				validate();
 				position += k;
 				//validate();
 				return *this;
 			}
 
-			const_iterator& operator-=(int64_t k) {
+			checked_const_iterator& operator-=(int64_t k) {
 				validate();
 				position -= k;
 				//validate();
@@ -708,16 +1276,16 @@ namespace zrdw {
 				return *(vec->front + position + k);
 			}
 
-			friend void swap(const_iterator& it1, const_iterator& it2) {
-				const_iterator temp(it1);
+			friend void swap(checked_const_iterator& it1, checked_const_iterator& it2) {
+				checked_const_iterator temp(it1);
 				it1 = it2;
 				it2 = temp;
 			}
 
 			// for k+iter
-			friend const_iterator operator+(int64_t k, const_iterator iter) {
+			friend checked_const_iterator operator+(int64_t k, checked_const_iterator iter) {
 				iter.validate();
-				const_iterator temp(iter);
+				checked_const_iterator temp(iter);
 				temp.position += k;
 				//temp.validate();
 				return temp;
@@ -745,6 +1313,12 @@ namespace zrdw {
 					return;
 				}
 
+				// check_light, bounds only
+				if (!Check::versions) {
+					if (isderef && outBounds(isderef)) throw std::out_of_range("Iterator is dereferencing a out-of-range vector position.");
+					return;
+				}
+
 				// no modification has been made
 				// though very unlikely, check if head has been changed while version are the same
 				if (vec_modify_version == vec->modify_version && head == vec->head) {
@@ -779,13 +1353,13 @@ namespace zrdw {
 
 		};
 
-		//iterator defined here
-		class iterator {
-			friend const_iterator;
+		//checked_iterator defined here
+		class checked_iterator {
+			friend checked_const_iterator;
 		private:
 			T* head; // iter.head = vec->head
 			int64_t position; // 0-indexed
-			vector<T>* vec;
+			vector* vec;
 			int64_t vec_modify_version, vec_realloc_reassign_version;
 
 		public:
@@ -795,15 +1369,15 @@ namespace zrdw {
 			using pointer = T*;
 			using reference = T&;
 
-			iterator(void) {
+			checked_iterator(void) {
 				head = nullptr;
 				position = 0;
 				vec = nullptr;
 				vec_modify_version = vec_realloc_reassign_version = 0;
 			}
 
-			// vector<T>* v?  vector<T>&
-			iterator(vector<T>& v, int64_t pos) {
+			// vector* v?  vector&
+			checked_iterator(vector& v, int64_t pos) {
 				head = v.head;
 				position = pos;
 				vec = &v;
@@ -814,8 +1388,7 @@ namespace zrdw {
 				//validate();
 			}
 
-			iterator(const iterator& iter) {
-				iter.validate();
+			checked_iterator(const checked_iterator& iter) {
 				this->head = iter.head;
 				this->position = iter.position;
 				this->vec = iter.vec;
@@ -823,8 +1396,7 @@ namespace zrdw {
 				this->vec_realloc_reassign_version = iter.vec_realloc_reassign_version;
 			}
 
-			iterator& operator=(const iterator& iter) {
-				iter.validate();
+			checked_iterator& operator=(const checked_iterator& iter) {
 				this->head = iter.head;
 				this->position = iter.position;
 				this->vec = iter.vec;
@@ -833,102 +1405,102 @@ namespace zrdw {
 				return *this;
 			}
 
-			bool operator==(const iterator& iter) const {
+			bool operator==(const checked_iterator& iter) const {
 				validate();
 				iter.validate();
 				if (this->vec != iter.vec) throw std::runtime_error("Comparing two different iters.");
 				return this->position == iter.position;
 			}
 
-			bool operator==(const const_iterator& iter) const {
+			bool operator==(const checked_const_iterator& iter) const {
 				validate();
 				iter.validate();
 				if (this->vec != iter.vec) throw std::runtime_error("Comparing two different iters.");
 				return this->position == iter.position;
 			}
 
-			bool operator<(const iterator& iter) const {
+			bool operator<(const checked_iterator& iter) const {
 				validate();
 				iter.validate();
 				if (this->vec != iter.vec) throw std::runtime_error("Comparing two different iters.");
 				return this->position < iter.position;
 			}
 
-			bool operator<(const const_iterator& iter) const {
+			bool operator<(const checked_const_iterator& iter) const {
 				validate();
 				iter.validate();
 				if (this->vec != iter.vec) throw std::runtime_error("Comparing two different iters.");
 				return this->position < iter.position;
 			}
 
-			iterator operator+(int64_t k) const {
+			checked_iterator operator+(int64_t k) const {
 				validate();
-				iterator temp(*this);
+				checked_iterator temp(*this);
 				temp.position += k;
 				//temp.validate();
 				return temp;
 			}
 
-			iterator operator-(int64_t k) const {
+			checked_iterator operator-(int64_t k) const {
 				validate();
-				iterator temp(*this);
+				checked_iterator temp(*this);
 				temp.position -= k;
 				//temp.validate();
 				return temp;
 			}
 
-			ptrdiff_t operator-(const iterator& iter) const {
+			ptrdiff_t operator-(const checked_iterator& iter) const {
 				if (this->vec != iter.vec) throw std::runtime_error("Two different iters.");
 				validate();
 				iter.validate();
 				return this->position - iter.position;
 			}
 
-			ptrdiff_t operator-(const const_iterator& iter) const {
+			ptrdiff_t operator-(const checked_const_iterator& iter) const {
 				if (this->vec != iter.vec) throw std::runtime_error("Two different iters.");
 				validate();
 				iter.validate();
 				return this->position - iter.position;
 			}
 
-			iterator& operator++(void) { //prefix	
+			checked_iterator& operator++(void) { //prefix	
 				validate();
 				++position;
 				//validate();
 				return *this;
 			}
 
-			iterator operator++(int) { // postfix
+			checked_iterator operator++(int) { // postfix
 				validate();
-				iterator temp(*this);
+				checked_iterator temp(*this);
 				++(*this);
 				// validate();
 				return temp;
 			}
 
-			iterator& operator--(void) { //prefix
+			checked_iterator& operator--(void) { //prefix
 				validate();
 				--position;
 				//validate();
 				return *this;
 			}
 
-			iterator operator--(int) { //postfix
+			checked_iterator operator--(int) { //postfix
 				validate();
-				iterator temp(*this);
+				checked_iterator temp(*this);
 				--(*this);
 				// validate();
 				return temp;
 			}
 
-			iterator& operator+=(int64_t k) {
+			checked_iterator& operator+=(int64_t k) {
 				validate();
 				position += k;
 				//validate();
 				return *this;
 			}
 
-			iterator& operator-=(int64_t k) {
+			checked_iterator& operator-=(int64_t k) {
 				validate();
 				position -= k;
 				//validate();
@@ -952,16 +1524,16 @@ namespace zrdw {
 			}
 
 			// for k+iter
-			friend iterator operator+(int64_t k, iterator iter) {
+			friend checked_iterator operator+(int64_t k, checked_iterator iter) {
 				iter.validate();
-				iterator temp(iter);
+				checked_iterator temp(iter);
 				temp.position += k;
 				//temp.validate();
 				return temp;
 			}
 
-			friend void swap(iterator& it1, iterator& it2) {
-				iterator temp(it1);
+			friend void swap(checked_iterator& it1, checked_iterator& it2) {
+				checked_iterator temp(it1);
 				it1 = it2;
 				it2 = temp;
 			}
@@ -987,6 +1559,12 @@ namespace zrdw {
 					return;
 				}
 
+				// check_light, bounds only
+				if (!Check::versions) {
+					if (isderef && outBounds(isderef)) throw std::out_of_range("Iterator is dereferencing a out-of-range vector position.");
+					return;
+				}
+
 				// no modification has been made
 				// though very unlikely, check if head has been changed while version are the same
 				if (vec_modify_version == vec->modify_version && head == vec->head) {
@@ -1022,25 +1600,56 @@ namespace zrdw {
 		};
 
 
+		// check_none iterates with raw pointers, the other policies with the checked iterators
+		using iterator = typename std::conditional<Check::bounds, checked_iterator, T*>::type;
+		using const_iterator = typename std::conditional<Check::bounds, checked_const_iterator, const T*>::type;
+
 		// const reference to vector must return const_iterator
 		const_iterator begin(void) const {
-			return const_iterator(*this, 0);
+			return make_iterator<const_iterator>(*this, 0);
 		}
 
 		const_iterator end(void) const {
-			return const_iterator(*this, len_elem);
+			return make_iterator<const_iterator>(*this, len_elem);
 		}
 
 		iterator begin(void) {
-			return iterator(*this, 0);
+			return make_iterator<iterator>(*this, 0);
 		}
 
 		iterator end(void) {
-			return iterator(*this, len_elem);
+			return make_iterator<iterator>(*this, len_elem);
+		}
+
+	private:
+		template <typename Iter, typename V>
+		static Iter make_iterator(V& v, int64_t pos, std::true_type) {
+			return Iter(v, pos);
+		}
+
+		template <typename Iter, typename V>
+		static Iter make_iterator(V& v, int64_t pos, std::false_type) {
+			return v.front + pos;
+		}
+
+		template <typename Iter, typename V>
+		static Iter make_iterator(V& v, int64_t pos) {
+			return make_iterator<Iter>(v, pos, std::integral_constant<bool, Check::bounds>{});
 		}
 
 	};
 
+	//storage types own their elems, valarray expressions hold them by reference rather than by copy
+	template <typename E>
+	struct is_storage : public std::false_type {};
+	template <typename T, typename Check, typename Alloc, typename Growth>
+	struct is_storage<vector<T, Check, Alloc, Growth>> : public std::true_type {};
+
+	//vector with inline room for N elems that only goes to the heap once it outgrows them,
+	//e.g. valarray<double, small_vector<double, 16>> for short arrays
+	template <typename T, size_t N, typename Check = check_default, typename Growth = grow_double>
+	using small_vector = vector<T, Check, inline_allocator<T, N>, Growth>;
+
 } //namespace zrdw
 
 #endif
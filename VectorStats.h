@@ -0,0 +1,183 @@
+#ifndef _VECTOR_STATS_H_
+#define _VECTOR_STATS_H_
+
+#include <cstdint>
+#include <iosfwd>
+#ifdef ZRDW_VECTOR_STATS
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <ostream>
+#include <typeinfo>
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+#endif
+
+namespace zrdw {
+
+	/*
+	allocation statistics of zrdw::vector, opt-in: compiled in only with -DZRDW_VECTOR_STATS.
+	counted per vector type and globally, to find the vectors that need reserve() or a different storage:
+		allocations, deallocations   buffers obtained from / given back to the allocator
+		reallocations                buffer replaced or remapped while holding elems
+		shifts                       elems moved inside the same buffer (recentering, insert, erase)
+		bytes_allocated, bytes_moved total bytes requested, and moved by reallocations and shifts
+		live_bytes, peak_live_bytes  bytes held right now, and the most ever held at once
+		peak_buffer_bytes            largest single buffer
+		slack_front/rear_bytes       unused room left at each end of the buffers when they were released
+	without the macro every hook below is an empty inline function and vector carries no extra state
+	*/
+#ifdef ZRDW_VECTOR_STATS
+	struct vector_stats {
+		std::atomic<int64_t> allocations{ 0 }, deallocations{ 0 }, reallocations{ 0 }, shifts{ 0 };
+		std::atomic<int64_t> bytes_allocated{ 0 }, bytes_moved{ 0 };
+		std::atomic<int64_t> live_bytes{ 0 }, peak_live_bytes{ 0 }, peak_buffer_bytes{ 0 };
+		std::atomic<int64_t> slack_front_bytes{ 0 }, slack_rear_bytes{ 0 };
+		const char* name = "";
+		vector_stats* next = nullptr; // registry list
+
+		static void raise(std::atomic<int64_t>& peak, int64_t v) {
+			int64_t p = peak.load(std::memory_order_relaxed);
+			while (p < v && !peak.compare_exchange_weak(p, v, std::memory_order_relaxed)) {}
+		}
+
+		void allocated(int64_t bytes) {
+			allocations.fetch_add(1, std::memory_order_relaxed);
+			bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+			raise(peak_live_bytes, live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+			raise(peak_buffer_bytes, bytes);
+		}
+
+		void released(int64_t bytes, int64_t front_slack, int64_t rear_slack) {
+			deallocations.fetch_add(1, std::memory_order_relaxed);
+			live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+			slack_front_bytes.fetch_add(front_slack, std::memory_order_relaxed);
+			slack_rear_bytes.fetch_add(rear_slack, std::memory_order_relaxed);
+		}
+
+		void reallocated(int64_t moved) {
+			reallocations.fetch_add(1, std::memory_order_relaxed);
+			bytes_moved.fetch_add(moved, std::memory_order_relaxed);
+		}
+
+		void shifted(int64_t moved) {
+			shifts.fetch_add(1, std::memory_order_relaxed);
+			bytes_moved.fetch_add(moved, std::memory_order_relaxed);
+		}
+
+		void reset(void) {
+			allocations = deallocations = reallocations = shifts = 0;
+			bytes_allocated = bytes_moved = 0;
+			peak_live_bytes = live_bytes.load(); // still held, so still live
+			peak_buffer_bytes = 0;
+			slack_front_bytes = slack_rear_bytes = 0;
+		}
+
+		void print(std::ostream& os) const {
+			os << name << '\n'
+				<< "  allocations " << allocations << ", deallocations " << deallocations
+				<< ", reallocations " << reallocations << ", shifts " << shifts << '\n'
+				<< "  bytes allocated " << bytes_allocated << ", bytes moved " << bytes_moved << '\n'
+				<< "  live bytes " << live_bytes << ", peak live bytes " << peak_live_bytes
+				<< ", peak buffer bytes " << peak_buffer_bytes << '\n'
+				<< "  slack front bytes " << slack_front_bytes << ", slack rear bytes " << slack_rear_bytes << '\n';
+		}
+	};
+
+	//every vector_stats in use, the global one first, then one per vector type in order of first use
+	struct vector_stats_registry {
+		std::mutex lock;
+		vector_stats global;
+		vector_stats* last = &global;
+
+		vector_stats_registry(void) {
+			global.name = "all vectors";
+		}
+
+		static vector_stats_registry& instance(void) {
+			static vector_stats_registry r;
+			return r;
+		}
+
+		void add(vector_stats& s) {
+			std::lock_guard<std::mutex> guard(lock);
+			last->next = &s;
+			last = &s;
+		}
+	};
+
+	inline vector_stats& global_vector_stats(void) {
+		return vector_stats_registry::instance().global;
+	}
+
+	// stats of one vector type, registered on first use
+	template <typename V>
+	vector_stats& type_vector_stats(void) {
+		struct registered : vector_stats {
+			registered(void) {
+				const char* raw = typeid(V).name();
+#if defined(__GNUC__)
+				int status = 0;
+				char* readable = abi::__cxa_demangle(raw, nullptr, nullptr, &status); // kept for the process lifetime
+				name = (status == 0) ? readable : raw;
+#else
+				name = raw;
+#endif
+				vector_stats_registry::instance().add(*this);
+			}
+		};
+		static registered s;
+		return s;
+	}
+
+	inline void dump_vector_stats(std::ostream& os) {
+		vector_stats_registry& r = vector_stats_registry::instance();
+		std::lock_guard<std::mutex> guard(r.lock);
+		for (const vector_stats* s = &r.global; s != nullptr; s = s->next) s->print(os);
+	}
+
+	inline void reset_vector_stats(void) {
+		vector_stats_registry& r = vector_stats_registry::instance();
+		std::lock_guard<std::mutex> guard(r.lock);
+		for (vector_stats* s = &r.global; s != nullptr; s = s->next) s->reset();
+	}
+#else
+	inline void dump_vector_stats(std::ostream&) {}
+	inline void reset_vector_stats(void) {}
+#endif
+
+	//hooks called by vector<...> = V, sizes in bytes
+	template <typename V>
+	struct vector_stats_hooks {
+#ifdef ZRDW_VECTOR_STATS
+		static void allocated(int64_t bytes) {
+			type_vector_stats<V>().allocated(bytes);
+			global_vector_stats().allocated(bytes);
+		}
+
+		static void released(int64_t bytes, int64_t front_slack, int64_t rear_slack) {
+			type_vector_stats<V>().released(bytes, front_slack, rear_slack);
+			global_vector_stats().released(bytes, front_slack, rear_slack);
+		}
+
+		static void reallocated(int64_t moved) {
+			type_vector_stats<V>().reallocated(moved);
+			global_vector_stats().reallocated(moved);
+		}
+
+		static void shifted(int64_t moved) {
+			type_vector_stats<V>().shifted(moved);
+			global_vector_stats().shifted(moved);
+		}
+#else
+		static void allocated(int64_t) {}
+		static void released(int64_t, int64_t, int64_t) {}
+		static void reallocated(int64_t) {}
+		static void shifted(int64_t) {}
+#endif
+	};
+
+} //namespace zrdw
+
+#endif
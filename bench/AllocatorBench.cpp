@@ -0,0 +1,92 @@
+/*
+arena and pool allocators against the default heap, for the short-lived buffers of valarray results:
+	g++ -std=c++17 -O2 -pthread -I.. AllocatorBench.cpp -o allocator_bench && ./allocator_bench
+first the allocators alone, ns per allocate/deallocate pair of n doubles, 8 live at a time (the arena released after each 8);
+then a request-scoped workload: four results of n elems computed from two inputs and summed,
+the arena released once per request, in us per request
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "Valarray.h"
+
+using namespace zrdw;
+
+namespace {
+	double sink = 0;
+
+	template <typename F>
+	double best_ns(F f, int reps) {
+		double best = 1e300;
+		for (int run = 0; run < 5; run++) {
+			auto t0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < reps; r++) f();
+			auto t1 = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / reps);
+		}
+		return best;
+	}
+
+	//then() runs after each round of 8, where an arena is released
+	template <typename A, typename F>
+	double pairs(A a, size_t n, F then) {
+		double* live[8];
+		return best_ns([&] {
+			for (int i = 0; i < 8; i++) live[i] = a.allocate(n);
+			for (int i = 0; i < 8; i++) {
+				live[i][0] = 1.0;
+				sink += live[i][0];
+				a.deallocate(live[i], n);
+			}
+			then();
+		}, 100000) / 8;
+	}
+
+	//one request: t1..t4 are results of the vector type V, as a loader or a kernel would keep them
+	template <typename V>
+	double request(const valarray<double>& x, const valarray<double>& y) {
+		V t1 = x*y + 1.0;
+		V t2 = t1*x - y;
+		V t3 = t2*t2;
+		V t4 = t3 + t1;
+		return t4.sum();
+	}
+
+	template <typename Alloc>
+	using result = valarray<double, vector<double, check_default, Alloc>>;
+
+	void workload(int64_t n) {
+		valarray<double> x(n, 1.5), y(n, 0.5);
+		int reps = static_cast<int>(std::max<int64_t>(10, (int64_t(1) << 22) / n));
+		double heap = best_ns([&] { sink += request<result<heap_allocator<double>>>(x, y); }, reps);
+		arena ar;
+		double in_arena = best_ns([&] {
+			{
+				arena_scope scope(ar);
+				sink += request<result<arena_allocator<double>>>(x, y);
+			}
+			ar.release();
+		}, reps);
+		pool pl;
+		double in_pool = best_ns([&] {
+			pool_scope scope(pl);
+			sink += request<result<pool_allocator<double>>>(x, y);
+		}, reps);
+		std::printf("request %8lld %9.2f %9.2f %9.2f\n", static_cast<long long>(n), heap / 1000, in_arena / 1000, in_pool / 1000);
+	}
+}
+
+int main() {
+	std::printf("%-7s %8s %9s %9s %9s\n", "ns/pair", "n", "heap", "arena", "pool");
+	for (size_t n : { size_t(4), size_t(64), size_t(1024), size_t(16384) }) {
+		arena ar;
+		pool pl;
+		double h = pairs(heap_allocator<double>(), n, [] {});
+		double a = pairs(arena_allocator<double>(ar), n, [&] { ar.release(); });
+		double p = pairs(pool_allocator<double>(pl), n, [] {});
+		std::printf("%-7s %8lld %9.2f %9.2f %9.2f\n", "alloc", static_cast<long long>(n), h, a, p);
+	}
+	std::printf("%-7s %8s %9s %9s %9s   (us per request)\n", "", "n", "heap", "arena", "pool");
+	for (int64_t n : { int64_t(16), int64_t(256), int64_t(4096), int64_t(65536) }) workload(n);
+	return sink == 0.123 ? 1 : 0;
+}
@@ -0,0 +1,67 @@
+/*
+throughput of the binary save/load of BinaryIO.h against the text path (operator<< of valarray, parsed back with >>):
+	g++ -std=c++17 -O2 -pthread -I.. BinaryIOBench.cpp -o binary_io_bench && ./binary_io_bench [dir]
+n doubles go to a file in dir (default /tmp), so the numbers are through the page cache, not the disk.
+text is written with 17 digits, as it must be to read back the same doubles;
+"save expr" saves a lazy x*2.0 + 1.0, evaluated chunk by chunk. MB/s of elem bytes, best of 3
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include "BinaryIO.h"
+
+using namespace zrdw;
+
+namespace {
+	double sink = 0;
+
+	template <typename F>
+	double best_seconds(F f) {
+		double best = 1e300;
+		for (int run = 0; run < 3; run++) {
+			auto t0 = std::chrono::steady_clock::now();
+			f();
+			best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+		}
+		return best;
+	}
+
+	valarray<double> text_load(const std::string& path) {
+		std::ifstream is(path);
+		vector<double> elems;
+		char c;
+		double x;
+		is >> c; // '{'
+		while (is >> x) {
+			elems.push_back(x);
+			is >> c; // ',' or '}'
+		}
+		return valarray<double>(std::move(elems));
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string dir = (argc > 1) ? argv[1] : "/tmp";
+	std::string bin = dir, txt = dir; //appended, not added: zrdw::operator+ would take string + literal
+	bin.append("/zrdw_io_bench.bin");
+	txt.append("/zrdw_io_bench.txt");
+	std::printf("%-10s %10s %10s %10s %10s\n", "n", "text save", "text load", "bin save", "bin load");
+	for (int64_t n : { int64_t(1) << 16, int64_t(1) << 22 }) {
+		valarray<double> x(n);
+		for (int64_t i = 0; i < n; i++) x[i] = 1.0 / (i + 1);
+		double mb = n*sizeof(double) / 1e6;
+		valarray<double> back;
+		double ts = best_seconds([&] { std::ofstream os(txt); os << std::setprecision(17) << x; });
+		double tl = best_seconds([&] { valarray<double> t = text_load(txt); sink += t[n / 2]; });
+		double bs = best_seconds([&] { save(bin, x); });
+		double bl = best_seconds([&] { load(bin, back); sink += back[n / 2]; });
+		double es = best_seconds([&] { save(bin, x*2.0 + 1.0); });
+		std::printf("%-10lld %10.0f %10.0f %10.0f %10.0f   save expr %.0f MB/s\n", static_cast<long long>(n), mb / ts, mb / tl, mb / bs, mb / bl, mb / es);
+	}
+	std::remove(bin.c_str());
+	std::remove(txt.c_str());
+	return sink == 0.123 ? 1 : 0;
+}
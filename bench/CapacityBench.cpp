@@ -0,0 +1,57 @@
+/*
+cost of filling a vector<double> by push_back under each growth policy, and with reserve() first:
+	g++ -std=c++17 -O2 -pthread -I.. CapacityBench.cpp -o capacity_bench && ./capacity_bench
+per row: ns per push (best of 5), how many times the buffer grew, and the slack left at the end
+in percent of the elems, which shrink_to_fit gives back
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "Vector.h"
+
+using namespace zrdw;
+
+namespace {
+	double sink = 0;
+
+	template <typename Growth>
+	void row(const char* name, int64_t n, bool reserved) {
+		using V = vector<double, check_default, heap_allocator<double>, Growth>;
+		double best = 1e300;
+		int64_t grows = 0, slack = 0;
+		int reps = static_cast<int>(std::max<int64_t>(1, (int64_t(1) << 24) / n));
+		for (int run = 0; run < 5; run++) {
+			auto t0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < reps; r++) {
+				V v;
+				if (reserved) v.reserve(n);
+				int64_t cap = v.capacity();
+				grows = 0;
+				for (int64_t i = 0; i < n; i++) {
+					v.push_back(static_cast<double>(i));
+					if (v.capacity() != cap) {
+						cap = v.capacity();
+						grows++;
+					}
+				}
+				slack = v.capacity() - v.size();
+				sink += v[n / 2];
+			}
+			auto t1 = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / n / reps);
+		}
+		std::printf("%-16s %10lld %9.2f %7lld %8.1f\n", name, static_cast<long long>(n), best,
+			static_cast<long long>(grows), 100.0*slack / n);
+	}
+}
+
+int main() {
+	std::printf("%-16s %10s %9s %7s %8s\n", "growth", "n", "ns/push", "grows", "slack %");
+	for (int64_t n : { int64_t(1000), int64_t(1) << 16, int64_t(1) << 22 }) {
+		row<grow_double>("grow_double", n, false);
+		row<grow_golden>("grow_golden", n, false);
+		row<grow_page<>>("grow_page", n, false);
+		row<grow_double>("reserve(n)", n, true);
+	}
+	return sink == 0.123 ? 1 : 0;
+}
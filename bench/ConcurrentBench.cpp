@@ -0,0 +1,83 @@
+/*
+multi-producer appends, concurrent_vector against one vector behind a mutex, from 1 to N producer threads:
+	g++ -std=c++17 -O2 -pthread -I.. ConcurrentBench.cpp -o concurrent_bench && ./concurrent_bench [max threads]
+each producer pushes its share of n doubles; the rows give millions of pushes per second, best of 5,
+and the freeze() into a contiguous valarray once they are joined.
+max threads defaults to std::thread::hardware_concurrency(); on a single CPU the rows above 1 only show
+the cost of contention, not any scaling
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ConcurrentVector.h"
+#include "Valarray.h"
+
+using namespace zrdw;
+
+namespace {
+	double sink = 0;
+	using clock = std::chrono::steady_clock;
+
+	double seconds(clock::time_point t0) {
+		return std::chrono::duration<double>(clock::now() - t0).count();
+	}
+
+	template <typename F>
+	double best_of_5(F f) {
+		double best = 1e300;
+		for (int run = 0; run < 5; run++) best = std::min(best, f());
+		return best;
+	}
+
+	//the producers each run f(first, last) over their share of [0, n)
+	template <typename F>
+	void produce(int threads, int64_t n, F f) {
+		std::vector<std::thread> pool;
+		for (int t = 0; t < threads; t++) pool.emplace_back(f, n*t / threads, n*(t + 1) / threads);
+		for (std::thread& th : pool) th.join();
+	}
+}
+
+int main(int argc, char** argv) {
+	int max_threads = (argc > 1) ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+	if (max_threads < 1) max_threads = 1;
+	const int64_t n = int64_t(1) << 23;
+	std::printf("hardware threads %u, n %lld\n", std::thread::hardware_concurrency(), static_cast<long long>(n));
+	std::printf("%8s %16s %16s %12s\n", "threads", "concurrent Mp/s", "mutex Mp/s", "freeze ms");
+	for (int threads = 1; threads <= std::max(max_threads, 4); threads *= 2) {
+		double freeze = 0;
+		double lock_free = best_of_5([&] {
+			concurrent_vector<double> c;
+			auto t0 = clock::now();
+			produce(threads, n, [&c](int64_t first, int64_t last) {
+				for (int64_t i = first; i < last; i++) c.push_back(static_cast<double>(i));
+			});
+			double s = seconds(t0);
+			auto f0 = clock::now();
+			valarray<double> v = c.freeze<valarray<double>>();
+			freeze = seconds(f0);
+			sink += v[n / 2];
+			return s;
+		});
+		double locked = best_of_5([&] {
+			vector<double> v;
+			std::mutex m;
+			auto t0 = clock::now();
+			produce(threads, n, [&v, &m](int64_t first, int64_t last) {
+				for (int64_t i = first; i < last; i++) {
+					std::lock_guard<std::mutex> g(m);
+					v.push_back(static_cast<double>(i));
+				}
+			});
+			double s = seconds(t0);
+			sink += v[n / 2];
+			return s;
+		});
+		std::printf("%8d %16.1f %16.1f %12.2f\n", threads, n / lock_free / 1e6, n / locked / 1e6, freeze*1e3);
+	}
+	return sink == 0.123 ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+/*
+throughput of the lazy elementwise math (Exp, Log, ... in Valarray.h) against a plain loop over libm, in ns per elem:
+	g++ -std=c++17 -O2 -pthread -I.. FastMathBench.cpp -o fastmath_bench && ./fastmath_bench
+	g++ -std=c++17 -O2 -pthread -I.. -DZRDW_STRICT_MATH FastMathBench.cpp -o fastmath_bench_strict
+the first column is b = f(a) through the SIMD engine, on FastMath.h, or on libm with ZRDW_STRICT_MATH;
+sin* and cos* run with one argument of 1e20 in the array, which takes them off the short reduction
+*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include "Valarray.h"
+
+using namespace zrdw;
+
+namespace {
+	double sink = 0;
+
+	//best of 5 runs of reps calls of f, per elem
+	template <typename F>
+	double ns_per_elem(F f, int64_t n, int reps) {
+		double best = 1e300;
+		for (int run = 0; run < 5; run++) {
+			auto t0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < reps; r++) f();
+			auto t1 = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / n / reps);
+		}
+		return best;
+	}
+
+	template <typename Lazy, typename Libm>
+	void row(const char* name, valarray<double>& a, Lazy lazy, Libm libm) {
+		int64_t n = a.size();
+		int reps = static_cast<int>(std::max<int64_t>(1, (int64_t(1) << 24) / n));
+		valarray<double> b(n);
+		double t_lazy = ns_per_elem([&] { b = lazy(a); sink += b[n / 2]; }, n, reps);
+		double t_libm = ns_per_elem([&] { for (int64_t i = 0; i < n; i++) b[i] = libm(a[i]); sink += b[n / 2]; }, n, reps);
+		std::printf("%-6s %10lld %9.2f %9.2f %8.1fx\n", name, static_cast<long long>(n), t_lazy, t_libm, t_libm / t_lazy);
+	}
+
+	void table(int64_t n) {
+		valarray<double> a(n);
+		for (int64_t i = 0; i < n; i++) a[i] = 0.001*(i % 1000) + 0.1;
+		row("exp", a, [](const valarray<double>& x) { return exp(x); }, [](double x) { return std::exp(x); });
+		row("log", a, [](const valarray<double>& x) { return log(x); }, [](double x) { return std::log(x); });
+		row("pow", a, [](const valarray<double>& x) { return pow(x, x); }, [](double x) { return std::pow(x, x); });
+		row("sin", a, [](const valarray<double>& x) { return sin(x); }, [](double x) { return std::sin(x); });
+		row("cos", a, [](const valarray<double>& x) { return cos(x); }, [](double x) { return std::cos(x); });
+		row("tanh", a, [](const valarray<double>& x) { return tanh(x); }, [](double x) { return std::tanh(x); });
+		row("erf", a, [](const valarray<double>& x) { return erf(x); }, [](double x) { return std::erf(x); });
+		row("abs", a, [](const valarray<double>& x) { return abs(x); }, [](double x) { return std::abs(x); });
+		row("sqrt", a, [](const valarray<double>& x) { return sqrt(x); }, [](double x) { return std::sqrt(x); });
+		a[n / 3] = 1e20;
+		row("sin*", a, [](const valarray<double>& x) { return sin(x); }, [](double x) { return std::sin(x); });
+		row("cos*", a, [](const valarray<double>& x) { return cos(x); }, [](double x) { return std::cos(x); });
+	}
+}
+
+int main() {
+#ifdef ZRDW_STRICT_MATH
+	std::printf("strict math (libm), isa %s\n", simd::name(simd::selected()));
+#else
+	std::printf("fast math, isa %s\n", simd::name(simd::selected()));
+#endif
+	std::printf("%-6s %10s %9s %9s %9s\n", "f", "n", "lazy", "libm loop", "speedup");
+	table(4096);
+	table(int64_t(1) << 22);
+	std::printf("*: one argument of 1e20, off the short reduction\n");
+	return sink == 0.123 ? 1 : 0;
+}
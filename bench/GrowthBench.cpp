@@ -0,0 +1,76 @@
+/*
+growth latency and TLB reach of vector<double> by push_back, on the heap and on mmap_allocator, against std::vector:
+	g++ -std=c++17 -O2 -pthread -I.. GrowthBench.cpp -o growth_bench && ./growth_bench
+per container: ns per push, the slowest single push (a regrow), minor page faults over the growth,
+then ns per read at random positions of the full buffer, where huge pages save the TLB misses.
+run it once with transparent huge pages on madvise (or always) and once with them never
+(/sys/kernel/mm/transparent_hugepage/enabled) to see what the 2 MB aligned, advised maps buy
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "Vector.h"
+
+namespace {
+	double sink = 0;
+
+	long minor_faults(void) {
+		rusage u;
+		getrusage(RUSAGE_SELF, &u);
+		return u.ru_minflt;
+	}
+
+	template <typename V>
+	void row(const char* name, int64_t n) {
+		using clock = std::chrono::steady_clock;
+		long faults = minor_faults();
+		double worst = 0;
+		auto t0 = clock::now();
+		{
+			V v;
+			auto last = t0;
+			for (int64_t i = 0; i < n; i++) {
+				v.push_back(static_cast<double>(i));
+				if ((i & (i - 1)) == 0 || i % 4096 == 0) { //sample around the regrows without timing every push
+					auto now = clock::now();
+					worst = std::max(worst, std::chrono::duration<double, std::micro>(now - last).count());
+					last = now;
+				}
+			}
+			double push = std::chrono::duration<double, std::nano>(clock::now() - t0).count() / n;
+			faults = minor_faults() - faults;
+
+			const double* p = &v[0];
+			uint64_t x = 88172645463325252ull, m = static_cast<uint64_t>(n);
+			int64_t reads = int64_t(1) << 24;
+			auto r0 = clock::now();
+			double s = 0;
+			for (int64_t i = 0; i < reads; i++) {
+				x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+				s += p[x % m];
+			}
+			double read = std::chrono::duration<double, std::nano>(clock::now() - r0).count() / reads;
+			sink += s;
+			std::printf("%-24s %10lld %9.2f %12.0f %10ld %9.2f\n", name, static_cast<long long>(n), push, worst, faults, read);
+		}
+	}
+}
+
+int main() {
+	std::string thp = "unknown";
+	std::ifstream f("/sys/kernel/mm/transparent_hugepage/enabled");
+	if (f) std::getline(f, thp);
+	std::printf("transparent huge pages: %s\n", thp.c_str());
+	std::printf("%-24s %10s %9s %12s %10s %9s\n", "container", "n", "ns/push", "worst us*", "minflt", "ns/read");
+	for (int64_t n : { int64_t(1) << 20, int64_t(1) << 25 }) {
+		row<std::vector<double>>("std::vector", n);
+		row<zrdw::vector<double>>("vector (heap)", n);
+		row<zrdw::vector<double, zrdw::check_default, zrdw::mmap_allocator<double>>>("vector (mmap_allocator)", n);
+	}
+	std::printf("*: longest span between samples, taken at each power of two and every 4096 pushes\n");
+	return sink == 0.123 ? 1 : 0;
+}
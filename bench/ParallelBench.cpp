@@ -0,0 +1,60 @@
+/*
+strong scaling of the parallel evaluation mode: one expression of fixed size on 1, 2, 4, ... threads:
+	g++ -std=c++17 -O2 -pthread -I.. ParallelBench.cpp -o parallel_bench && ./parallel_bench [max threads] [grain bytes]
+max threads defaults to std::thread::hardware_concurrency(), grain bytes to the library's default.
+per row, ms per evaluation (best of 5), speedup and efficiency against 1 thread, for a memory-bound
+a = b*c + d and a compute-bound a = exp(b)*sin(c); on a single CPU the rows above 1 only show the pool's overhead
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "Valarray.h"
+
+using namespace zrdw;
+
+namespace {
+	double sink = 0;
+
+	template <typename F>
+	double best_ms(F f) {
+		double best = 1e300;
+		for (int run = 0; run < 5; run++) {
+			auto t0 = std::chrono::steady_clock::now();
+			f();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+		}
+		return best;
+	}
+}
+
+int main(int argc, char** argv) {
+	int max_threads = (argc > 1) ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+	if (max_threads < 1) max_threads = 1;
+	if (argc > 2) parallel::set_grain_bytes(std::atoll(argv[2]));
+	const int64_t n = int64_t(1) << 24;
+	valarray<double> a(n), b(n), c(n), d(n);
+	for (int64_t i = 0; i < n; i++) {
+		b[i] = 1.0 + 0.001*(i % 997);
+		c[i] = 0.5 + 0.002*(i % 89);
+		d[i] = 0.25*(i % 13);
+	}
+	std::printf("hardware threads %u, n %lld, grain %lld bytes\n", std::thread::hardware_concurrency(),
+		static_cast<long long>(n), static_cast<long long>(parallel::grain_bytes()));
+	std::printf("%8s %12s %8s %6s %14s %8s %6s\n", "threads", "b*c + d ms", "speedup", "eff", "exp*sin ms", "speedup", "eff");
+	double base_mem = 0, base_cpu = 0;
+	for (int threads = 1; threads <= std::max(max_threads, 4); threads *= 2) {
+		parallel::set_threads(threads);
+		double mem = best_ms([&] { a = b*c + d; sink += a[n / 2]; });
+		double cpu = best_ms([&] { a = exp(b)*sin(c); sink += a[n / 2]; });
+		if (threads == 1) {
+			base_mem = mem;
+			base_cpu = cpu;
+		}
+		std::printf("%8d %12.2f %8.2f %6.2f %14.2f %8.2f %6.2f\n", threads, mem, base_mem / mem, base_mem / mem / threads,
+			cpu, base_cpu / cpu, base_cpu / cpu / threads);
+	}
+	parallel::set_threads(1);
+	return sink == 0.123 ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+/*
+the relocation layer of Vector.h, memcpy/memmove for trivially copyable elems against per-elem construction:
+	g++ -std=c++17 -O2 -pthread -I.. RelocationBench.cpp -o relocation_bench && ./relocation_bench
+double takes the memcpy path; boxed, a double with a user-written copy and move, takes the per-elem one,
+as any non trivially copyable T does. ns per elem, best of 5, for a copy, growth by push_back
+from empty, and a copy then an insert in the middle of the full copy, which relocates it into a new buffer
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "Vector.h"
+
+using namespace zrdw;
+
+namespace {
+	double sink = 0;
+
+	struct boxed {
+		double v;
+		boxed(double x = 0) : v(x) {}
+		boxed(const boxed& b) : v(b.v) {}
+		boxed(boxed&& b) noexcept : v(b.v) {}
+		boxed& operator=(const boxed& b) { v = b.v; return *this; }
+		boxed& operator=(boxed&& b) noexcept { v = b.v; return *this; }
+		~boxed(void) {}
+	};
+
+	double value(double x) { return x; }
+	double value(const boxed& x) { return x.v; }
+
+	template <typename F>
+	double ns_per_elem(F f, int64_t n, int reps) {
+		double best = 1e300;
+		for (int run = 0; run < 5; run++) {
+			auto t0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < reps; r++) f();
+			auto t1 = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / n / reps);
+		}
+		return best;
+	}
+
+	template <typename T>
+	void row(const char* name, int64_t n) {
+		using V = vector<T, check_none>;
+		int reps = static_cast<int>(std::max<int64_t>(1, (int64_t(1) << 24) / n));
+		V a;
+		for (int64_t i = 0; i < n; i++) a.push_back(T(static_cast<double>(i)));
+		double copy = ns_per_elem([&] { V b(a); sink += value(b[n / 2]); }, n, reps);
+		double grow = ns_per_elem([&] {
+			V b;
+			for (int64_t i = 0; i < n; i++) b.push_back(T(static_cast<double>(i)));
+			sink += value(b[n / 2]);
+		}, n, reps);
+		double insert = ns_per_elem([&] {
+			V b(a);
+			b.shrink_to_fit();
+			b.insert(n / 2, T(1.0));
+			sink += value(b[n / 2]);
+		}, n, reps);
+		std::printf("%-8s %10lld %9.2f %9.2f %13.2f\n", name, static_cast<long long>(n), copy, grow, insert);
+	}
+}
+
+int main() {
+	std::printf("%-8s %10s %9s %9s %13s\n", "T", "n", "copy", "push_back", "copy+insert");
+	for (int64_t n : { int64_t(1) << 10, int64_t(1) << 16, int64_t(1) << 22 }) {
+		row<double>("double", n);
+		row<boxed>("boxed", n);
+	}
+	return sink == 0.123 ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+/*
+throughput of the SIMD evaluation engine on each instruction set the CPU has, against a plain loop:
+	g++ -std=c++17 -O2 -pthread -I.. SimdBench.cpp -o simd_bench && ./simd_bench
+the engine is limited to each ISA in turn with simd::limit; ns per elem, best of 5, n in cache and in memory.
+the plain loop is what the compiler makes of for (i) out[i] = b[i]*c[i] + d[i] at the same flags
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "Valarray.h"
+
+using namespace zrdw;
+
+namespace {
+	double sink = 0;
+
+	template <typename F>
+	double ns_per_elem(F f, int64_t n) {
+		int reps = static_cast<int>(std::max<int64_t>(1, (int64_t(1) << 24) / n));
+		double best = 1e300;
+		for (int run = 0; run < 5; run++) {
+			auto t0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < reps; r++) f();
+			auto t1 = std::chrono::steady_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::nano>(t1 - t0).count() / n / reps);
+		}
+		return best;
+	}
+
+	void table(int64_t n) {
+		valarray<double> a(n), b(n), c(n), d(n);
+		std::vector<int64_t> idx(n);
+		for (int64_t i = 0; i < n; i++) {
+			b[i] = 1.0 + 0.001*(i % 997);
+			c[i] = 0.5 + 0.002*(i % 89);
+			d[i] = 0.25*(i % 13);
+			idx[i] = (i * 7919) % n;
+		}
+		const double* pb = &b[0];
+		const double* pc = &c[0];
+		const double* pd = &d[0];
+		double* pa = &a[0];
+		double loop = ns_per_elem([&] { for (int64_t i = 0; i < n; i++) pa[i] = pb[i]*pc[i] + pd[i]; sink += pa[n / 2]; }, n);
+		std::printf("n = %lld, plain loop b*c + d: %.3f ns/elem\n", static_cast<long long>(n), loop);
+		std::printf("%-8s %9s %9s %9s %9s %9s\n", "isa", "b*c + d", "sum", "sqrt", "exp", "gather");
+		for (simd::isa i : { simd::generic, simd::sse2, simd::avx2, simd::avx512 }) {
+			if (i > simd::detect()) break;
+			simd::limit(i);
+			double fma = ns_per_elem([&] { a = b*c + d; sink += a[n / 2]; }, n);
+			double sum = ns_per_elem([&] { sink += (b*c).sum(); }, n);
+			double root = ns_per_elem([&] { a = sqrt(b); sink += a[n / 2]; }, n);
+			double ex = ns_per_elem([&] { a = exp(b); sink += a[n / 2]; }, n);
+			double gather = ns_per_elem([&] { a = b.indirect(idx)*c; sink += a[n / 2]; }, n);
+			std::printf("%-8s %9.3f %9.3f %9.3f %9.3f %9.3f\n", simd::name(i), fma, sum, root, ex, gather);
+		}
+		simd::limit(simd::detect());
+	}
+}
+
+int main() {
+	std::printf("detected isa %s\n", simd::name(simd::detect()));
+	table(4096);
+	table(int64_t(1) << 22);
+	return sink == 0.123 ? 1 : 0;
+}